@@ -3,9 +3,15 @@ from pathlib import Path
 from typing import Optional, Sequence
 import argparse
 import sys
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 import json
 
+ROOT = Path(__file__).resolve().parents[2]
+if str(ROOT) not in sys.path:
+    sys.path.insert(0, str(ROOT))
+
+from tools.pass_timer import DISABLED, PassTimer
+
 @dataclass
 class ProjectCommandOptions:
     """
@@ -14,6 +20,10 @@ class ProjectCommandOptions:
     project: Path
     out_bin: Optional[Path]
     log_file: Optional[Path]
+    jobs: int = 0
+    time_passes: bool = False
+    profile_json: Optional[Path] = None
+    timer: PassTimer = field(default_factory=lambda: DISABLED)
 
 
 def log_if_needed(log_file: Optional[Path], message: str) -> None:
@@ -79,6 +89,7 @@ def run_vitte_driver(
     project: Path,
     out_bin: Optional[Path],
     log_file: Optional[Path],
+    jobs: int = 0,
 ) -> int:
     """
     Point d'unification pour appeler le driver Vitte.
@@ -87,6 +98,7 @@ def run_vitte_driver(
     project  : chemin vers le manifest .muf
     out_bin  : binaire de sortie (build), None pour check
     log_file : log à produire (optionnel)
+    jobs     : workers du build (DriverFlags.jobs), 0 = automatique
 
     Contrat codes retour :
       0 -> succès
@@ -108,7 +120,7 @@ def run_vitte_driver(
 
     msg = (
         f"[vittec][host] run_vitte_driver(mode={mode}, "
-        f"project={project}, out_bin={out_bin_resolved}, log={log_path})\n"
+        f"project={project}, out_bin={out_bin_resolved}, log={log_path}, jobs={jobs})\n"
         "  (TODO: remplacer par un appel au module vitte.compiler.driver)"
     )
     print(msg)
@@ -122,7 +134,8 @@ def cmd_build_project(opts: ProjectCommandOptions) -> int:
     root = opts.project.parent
 
     # 1) Scanner les sources Vitte
-    sources = find_vitte_sources(opts.project)
+    with opts.timer.phase("scan-sources"):
+        sources = find_vitte_sources(opts.project)
     rel_sources = [str(p.relative_to(root)) for p in sources]
 
     msg = (
@@ -136,12 +149,14 @@ def cmd_build_project(opts: ProjectCommandOptions) -> int:
     log_if_needed(opts.log_file, msg)
 
     # 2) Appel contractuel au driver Vitte (futur point unique)
-    code = run_vitte_driver(
-        mode="build",
-        project=opts.project,
-        out_bin=opts.out_bin,
-        log_file=opts.log_file,
-    )
+    with opts.timer.phase("driver", str(opts.project)):
+        code = run_vitte_driver(
+            mode="build",
+            project=opts.project,
+            out_bin=opts.out_bin,
+            log_file=opts.log_file,
+            jobs=opts.jobs,
+        )
 
     # 3) Si le driver signale une erreur, on propage immédiatement
     if code != 0:
@@ -176,7 +191,8 @@ def cmd_build_project(opts: ProjectCommandOptions) -> int:
 
 def cmd_check_project(opts: ProjectCommandOptions) -> int:
     root = opts.project.parent
-    sources = find_vitte_sources(opts.project)
+    with opts.timer.phase("scan-sources"):
+        sources = find_vitte_sources(opts.project)
     msg = (
         f"[vittec][bootstrap] check projet (Muffin) : {opts.project}\n"
         f"  root     = {root}\n"
@@ -187,16 +203,33 @@ def cmd_check_project(opts: ProjectCommandOptions) -> int:
     print(msg)
     log_if_needed(opts.log_file, msg)
 
-    code = run_vitte_driver(
-        mode="check",
-        project=opts.project,
-        out_bin=None,
-        log_file=opts.log_file,
-    )
+    with opts.timer.phase("driver", str(opts.project)):
+        code = run_vitte_driver(
+            mode="check",
+            project=opts.project,
+            out_bin=None,
+            log_file=opts.log_file,
+            jobs=opts.jobs,
+        )
 
     return code
 
 
+def run_timed(cmd, opts: ProjectCommandOptions) -> int:
+    """
+    Exécute `cmd(opts)` en mesurant ses phases si --time-passes ou
+    --profile-json est demandé ; le rapport et la trace sont produits même
+    si la commande échoue.
+    """
+    if not (opts.time_passes or opts.profile_json):
+        return cmd(opts)
+    opts.timer = PassTimer(enabled=True)
+    try:
+        return cmd(opts)
+    finally:
+        opts.timer.finish(opts.time_passes, opts.profile_json)
+
+
 def main(argv: Sequence[str] | None = None) -> int:
     parser = argparse.ArgumentParser(
         prog="vittec-stage1",
@@ -213,10 +246,16 @@ def main(argv: Sequence[str] | None = None) -> int:
     p_build.add_argument("project", type=Path)
     p_build.add_argument("--out-bin", type=Path)
     p_build.add_argument("--log-file", type=Path)
+    p_build.add_argument("-j", "--jobs", type=int, default=0)
+    p_build.add_argument("--time-passes", action="store_true")
+    p_build.add_argument("--profile-json", type=Path)
 
     p_check = sub.add_parser("check", help="Vérifie un projet (stub).")
     p_check.add_argument("project", type=Path)
     p_check.add_argument("--log-file", type=Path)
+    p_check.add_argument("-j", "--jobs", type=int, default=0)
+    p_check.add_argument("--time-passes", action="store_true")
+    p_check.add_argument("--profile-json", type=Path)
 
     args = parser.parse_args(list(argv) if argv is not None else None)
 
@@ -229,16 +268,22 @@ def main(argv: Sequence[str] | None = None) -> int:
             project=args.project,
             out_bin=args.out_bin,
             log_file=args.log_file,
+            jobs=args.jobs,
+            time_passes=args.time_passes,
+            profile_json=args.profile_json,
         )
-        return cmd_build_project(opts)
+        return run_timed(cmd_build_project, opts)
 
     if args.command == "check":
         opts = ProjectCommandOptions(
             project=args.project,
             out_bin=None,
             log_file=args.log_file,
+            jobs=args.jobs,
+            time_passes=args.time_passes,
+            profile_json=args.profile_json,
         )
-        return cmd_check_project(opts)
+        return run_timed(cmd_check_project, opts)
 
     parser.print_help()
     return 1
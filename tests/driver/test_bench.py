@@ -0,0 +1,191 @@
+from __future__ import annotations
+
+from typing import List
+import json
+import unittest
+
+from tests.runtime.test_vm_ops import Const, ConstTag, FunctionEntry, Opcode, VmValueTag, encode_inst, make_chunk, vm_run
+from tools.bench_harness import (
+    BenchCase,
+    BenchConfig,
+    BenchStats,
+    Harness,
+    any_regressed,
+    bench_json,
+    compare,
+    median_abs_dev,
+    median_sorted,
+    parse_baseline,
+    report,
+)
+
+
+class FakeClock:
+    """Horloge déterministe : chaque run avance de `ps_per_iter` ps par itération."""
+
+    def __init__(self) -> None:
+        self.now = 0
+
+    def __call__(self) -> int:
+        return self.now
+
+    def case(self, name: str, ps_per_iter: int, unit: str = "ops", per_iter: int = 1) -> BenchCase:
+        def run(iters: int) -> int:
+            self.now += iters * ps_per_iter // 1000
+            return 0
+        return BenchCase(name, unit, per_iter, run)
+
+
+def stats(name: str, median_ps: int, mad_ps: int = 0) -> BenchStats:
+    return BenchStats(name, "ops", 1, 1000, 15, median_ps, mad_ps, median_ps, 0)
+
+
+class BenchStatisticsTests(unittest.TestCase):
+    def test_median_and_mad(self) -> None:
+        self.assertEqual(median_sorted([]), 0)
+        self.assertEqual(median_sorted([1, 3, 9]), 3)
+        self.assertEqual(median_sorted([1, 3, 5, 9]), 4)
+        values = sorted([10, 11, 12, 13, 1000])
+        # l'aberrant ne déplace ni la médiane ni la MAD
+        self.assertEqual(median_sorted(values), 12)
+        self.assertEqual(median_abs_dev(values, 12), 1)
+
+    def test_calibration_reaches_sample_duration(self) -> None:
+        clock = FakeClock()
+        harness = Harness(clock=clock, config=BenchConfig(warmup_ns=1_000, sample_ns=1_000_000, samples=5))
+        result = harness.measure(clock.case("flat", 4_000))
+        self.assertGreaterEqual(result.iters * 4, 1_000_000)
+        # l'estimation linéaire vise juste : pas de dépassement à ×10
+        self.assertLess(result.iters * 4, 2_000_000)
+        self.assertEqual(result.median_ps, 4_000)
+        self.assertEqual(result.mad_ps, 0)
+        self.assertEqual(result.per_sec, 250_000_000)
+
+    def test_filter_selects_cases(self) -> None:
+        clock = FakeClock()
+        harness = Harness(clock=clock, config=BenchConfig(filter="vm.", warmup_ns=0, sample_ns=1_000, samples=3))
+        results = harness.run_suite([clock.case("vm.calls", 1_000), clock.case("zip.read", 1_000)])
+        self.assertEqual([r.name for r in results], ["vm.calls"])
+
+
+class BenchBaselineTests(unittest.TestCase):
+    def test_json_round_trip(self) -> None:
+        results = [stats("vm.dispatch", 12_345, 40), stats("vm.gc", 99_000, 800)]
+        text = bench_json(results)
+        self.assertEqual(len(text.splitlines()), 4)   # un résultat par ligne
+        self.assertEqual(json.loads(text)["version"], 1)
+        self.assertEqual(parse_baseline(text), {"vm.dispatch": (12_345, 40), "vm.gc": (99_000, 800)})
+
+    def test_regression_needs_threshold_and_noise_margin(self) -> None:
+        baseline = {"a": (100_000, 0), "b": (100_000, 0), "c": (100_000, 0), "d": (100_000, 0)}
+        results = [
+            stats("a", 104_000, 100),    # sous le seuil de 5 %
+            stats("b", 110_000, 100),    # +10 %, bien au-delà du bruit
+            stats("c", 110_000, 5_000),  # +10 % mais < 3 MAD : bruit
+            stats("d", 80_000, 100),     # plus rapide
+            stats("new", 1_000, 0),      # absent de la baseline
+        ]
+        verdicts = compare(results, baseline, 5)
+        self.assertEqual([v.regressed for v in verdicts], [False, True, False, False, False])
+        self.assertEqual(verdicts[1].delta_pct, 10)
+        self.assertEqual(verdicts[3].delta_pct, -20)
+        self.assertEqual(verdicts[4].base_ps, 0)
+        self.assertTrue(any_regressed(verdicts))
+        text = report(results, verdicts)
+        self.assertIn("+10% REGRESSION", text)
+        self.assertIn("-20%", text)
+
+
+# Programmes de src/vitte/runtime/cli/bench.vitte (mêmes constantes, mêmes
+# locals : 0 = i, 1 = accumulateur / holder, 2 = temporaire).
+K_ZERO, K_ONE, K_N, K_THREE, K_MOD, K_LHS, K_RHS = range(7)
+DISPATCH_MOD = 1000003
+
+
+def body_code(kind: str) -> List[int]:
+    op = encode_inst
+    if kind == "dispatch":
+        return (op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_CONST, K_THREE) + op(Opcode.OP_MUL)
+                + op(Opcode.OP_LOAD_LOCAL, 0) + op(Opcode.OP_ADD) + op(Opcode.OP_CONST, K_ONE) + op(Opcode.OP_ADD)
+                + op(Opcode.OP_CONST, K_MOD) + op(Opcode.OP_MOD) + op(Opcode.OP_STORE_LOCAL, 1))
+    if kind == "calls":
+        return op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_CALL, 1) + op(Opcode.OP_STORE_LOCAL, 1)
+    if kind == "fields":
+        return (op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_LOAD_FIELD, 0)
+                + op(Opcode.OP_CONST, K_ONE) + op(Opcode.OP_ADD) + op(Opcode.OP_STORE_FIELD, 0))
+    if kind == "concat":
+        return (op(Opcode.OP_CONST, K_LHS) + op(Opcode.OP_CONST, K_RHS) + op(Opcode.OP_STD_CONCAT_STRING)
+                + op(Opcode.OP_STORE_LOCAL, 1))
+    return (op(Opcode.OP_ALLOC_HEAP, 2 | 1 << 8) + op(Opcode.OP_STORE_LOCAL, 2) + op(Opcode.OP_LOAD_LOCAL, 2)
+            + op(Opcode.OP_LOAD_LOCAL, 0) + op(Opcode.OP_STORE_FIELD, 0) + op(Opcode.OP_LOAD_LOCAL, 1)
+            + op(Opcode.OP_LOAD_LOCAL, 2) + op(Opcode.OP_STORE_FIELD, 0))
+
+
+def main_code(kind: str) -> List[int]:
+    op = encode_inst
+    code = op(Opcode.OP_CONST, K_ZERO) + op(Opcode.OP_STORE_LOCAL, 0)
+    if kind in ("dispatch", "calls"):
+        code += op(Opcode.OP_CONST, K_ZERO) + op(Opcode.OP_STORE_LOCAL, 1)
+    if kind in ("fields", "gc"):
+        code += (op(Opcode.OP_ALLOC_HEAP, 2 | 1 << 8) + op(Opcode.OP_STORE_LOCAL, 1) + op(Opcode.OP_LOAD_LOCAL, 1)
+                 + op(Opcode.OP_CONST, K_ZERO) + op(Opcode.OP_STORE_FIELD, 0))
+    test = op(Opcode.OP_LOAD_LOCAL, 0) + op(Opcode.OP_CONST, K_N) + op(Opcode.OP_CMP_EQ)
+    incr = op(Opcode.OP_LOAD_LOCAL, 0) + op(Opcode.OP_CONST, K_ONE) + op(Opcode.OP_ADD) + op(Opcode.OP_STORE_LOCAL, 0)
+    body = body_code(kind)
+    jmp = len(op(Opcode.OP_JMP, 0))
+    code += test + op(Opcode.OP_JMP_IF, len(body) + len(incr) + jmp) + body + incr
+    code += op(Opcode.OP_JMP, -(len(test) + jmp + len(body) + len(incr) + jmp))
+    if kind == "fields":
+        code += op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_LOAD_FIELD, 0)
+    elif kind == "gc":
+        code += (op(Opcode.OP_LOAD_LOCAL, 1) + op(Opcode.OP_LOAD_FIELD, 0) + op(Opcode.OP_LOAD_FIELD, 0)
+                 + op(Opcode.OP_CONST, K_ONE) + op(Opcode.OP_ADD))
+    elif kind == "concat":
+        code += op(Opcode.OP_LOAD_LOCAL, 0)
+    else:
+        code += op(Opcode.OP_LOAD_LOCAL, 1)
+    return code + op(Opcode.OP_RET)
+
+
+def run_program(kind: str, iters: int) -> int:
+    consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, iters), Const(ConstTag.I64, 3),
+              Const(ConstTag.I64, DISPATCH_MOD), Const(ConstTag.STRING, "bench"), Const(ConstTag.STRING, "-vm")]
+    code = main_code(kind)
+    callee = (encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_CONST, K_ONE)
+              + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_RET))
+    functions = [FunctionEntry(K_LHS, 0, len(code), 0, 3, 8, 1), FunctionEntry(K_RHS, len(code), len(callee), 1, 0, 4)]
+    result = vm_run(make_chunk(consts, code + callee, functions))
+    assert result.tag is VmValueTag.I64, result
+    return result.value
+
+
+def dispatch_expected(iters: int) -> int:
+    acc = 0
+    for i in range(iters):
+        acc = (acc * 3 + i + 1) % DISPATCH_MOD
+    return acc
+
+
+class VmBenchProgramTests(unittest.TestCase):
+    def test_programs_return_their_checksum(self) -> None:
+        for iters in (1, 2, 37):
+            with self.subTest(iters=iters):
+                self.assertEqual(run_program("dispatch", iters), dispatch_expected(iters))
+                for kind in ("calls", "fields", "concat", "gc"):
+                    self.assertEqual(run_program(kind, iters), iters, kind)
+
+    def test_dispatch_loop_is_nineteen_instructions(self) -> None:
+        # per_iter de vm.dispatch : corps, test + jmp_if, incrément + jmp
+        def count(code: List[int]) -> int:
+            n = pc = 0
+            while pc < len(code):
+                pc += 2 + 4 * code[pc + 1]
+                n += 1
+            return n
+        self.assertEqual(count(body_code("dispatch")), 10)
+        # hors prologue (i = 0, acc = 0) et épilogue (load acc, ret)
+        self.assertEqual(count(main_code("dispatch")) - 4 - 2, 19)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,147 @@
+from __future__ import annotations
+
+from pathlib import Path
+from typing import Dict, List, Optional
+import os
+import tempfile
+import unittest
+
+
+CACHE_FORMAT = 1
+COMPILER_VERSION = "vittec-0.1.0"
+FNV_OFFSET = 0xCBF29CE484222325
+FNV_PRIME = 0x100000001B3
+MASK = (1 << 64) - 1
+
+
+def fnv1a(seed: int, text: str) -> int:
+    h = seed
+    for b in text.encode():
+        h = ((h ^ b) * FNV_PRIME) & MASK
+    return h
+
+
+def hash_text(text: str) -> int:
+    return fnv1a(FNV_OFFSET, text)
+
+
+def hexkey(h: int) -> str:
+    return f"{h:016x}"
+
+
+def mix(a: int, b: int) -> int:
+    return fnv1a(a, hexkey(b))
+
+
+def options_key(options: str) -> int:
+    h = hash_text(COMPILER_VERSION)
+    h = fnv1a(h, f"|format={CACHE_FORMAT}")
+    return fnv1a(h, "|" + options)
+
+
+def entry_header(kind: str, key: int, payload: str) -> str:
+    return (
+        f"vittec-cache {CACHE_FORMAT} {kind} {hexkey(key)} "
+        f"{len(payload)} {hexkey(hash_text(payload))}\n"
+    )
+
+
+class BuildCache:
+    def __init__(self, root: Path) -> None:
+        self.root = root / "target/cache" / f"v{CACHE_FORMAT}"
+        self.hits = 0
+        self.misses = 0
+
+    def entry_path(self, kind: str, key: int) -> Path:
+        return self.root / kind / hexkey(key)
+
+    def get(self, kind: str, key: int) -> Optional[str]:
+        p = self.entry_path(kind, key)
+        if not p.exists():
+            self.misses += 1
+            return None
+        text = p.read_text(encoding="utf-8")
+        nl = text.find("\n")
+        if nl < 0:
+            self.misses += 1
+            return None
+        payload = text[nl + 1:]
+        if text[: nl + 1] != entry_header(kind, key, payload):
+            self.misses += 1
+            return None
+        self.hits += 1
+        return payload
+
+    def put(self, kind: str, key: int, payload: str) -> None:
+        p = self.entry_path(kind, key)
+        p.parent.mkdir(parents=True, exist_ok=True)
+        tmp = p.with_name(p.name + f".tmp-{os.getpid()}")
+        tmp.write_text(entry_header(kind, key, payload) + payload, encoding="utf-8")
+        os.replace(tmp, p)
+
+
+def check_keys(contents: List[str], ifaces: List[str], deps: List[List[int]]) -> List[int]:
+    base = options_key("check")
+    out = []
+    for i, text in enumerate(contents):
+        key = mix(base, hash_text(text))
+        for d in deps[i]:
+            key = mix(key, hash_text(ifaces[d]))
+        out.append(key)
+    return out
+
+
+class HashTests(unittest.TestCase):
+    def test_fnv1a_reference_vectors(self) -> None:
+        self.assertEqual(hash_text(""), 0xCBF29CE484222325)
+        self.assertEqual(hash_text("a"), 0xAF63DC4C8601EC8C)
+        self.assertEqual(hash_text("foobar"), 0x85944171F73967E8)
+
+    def test_hex_is_fixed_width(self) -> None:
+        self.assertEqual(hexkey(0), "0" * 16)
+        self.assertEqual(hexkey(0xABC), "0000000000000abc")
+
+    def test_options_change_the_key(self) -> None:
+        self.assertNotEqual(options_key("build opt=-O1"), options_key("build opt=-O2"))
+        self.assertNotEqual(mix(1, 2), mix(2, 1))
+
+
+class InvalidationTests(unittest.TestCase):
+    # util (0) est importé par app (1).
+    DEPS = [[], [0]]
+
+    def test_body_edit_only_rechecks_the_edited_module(self) -> None:
+        before = check_keys(["fn f() body1", "app"], ["fn f()->i64", "fn main()"], self.DEPS)
+        after = check_keys(["fn f() body2", "app"], ["fn f()->i64", "fn main()"], self.DEPS)
+        self.assertNotEqual(before[0], after[0])
+        self.assertEqual(before[1], after[1])
+
+    def test_signature_edit_rechecks_importers(self) -> None:
+        before = check_keys(["util", "app"], ["fn f()->i64", "fn main()"], self.DEPS)
+        after = check_keys(["util2", "app"], ["fn f(i64)->i64", "fn main()"], self.DEPS)
+        self.assertNotEqual(before[1], after[1])
+
+
+class EntryTests(unittest.TestCase):
+    def test_round_trip_and_corruption_is_a_miss(self) -> None:
+        with tempfile.TemporaryDirectory() as d:
+            c = BuildCache(Path(d))
+            self.assertIsNone(c.get("check", 42))
+            c.put("check", 42, "W|W3001|10|3|Fonction sans corps\n")
+            self.assertEqual(c.get("check", 42), "W|W3001|10|3|Fonction sans corps\n")
+            p = c.entry_path("check", 42)
+            p.write_text(p.read_text(encoding="utf-8")[:-5], encoding="utf-8")  # tronqué
+            self.assertIsNone(c.get("check", 42))
+            self.assertEqual((c.hits, c.misses), (1, 2))
+
+    def test_entry_under_another_key_is_rejected(self) -> None:
+        with tempfile.TemporaryDirectory() as d:
+            c = BuildCache(Path(d))
+            c.put("build", 1, "ir")
+            os.replace(c.entry_path("build", 1), c.entry_path("build", 2))
+            self.assertIsNone(c.get("build", 2))
+            self.assertEqual(list(c.entry_path("build", 1).parent.glob("*.tmp-*")), [])
+
+
+if __name__ == "__main__":
+    unittest.main()
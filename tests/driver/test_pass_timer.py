@@ -0,0 +1,101 @@
+from __future__ import annotations
+
+from pathlib import Path
+import json
+import tempfile
+import unittest
+
+from tools.frontend_host import FrontendDatabase
+from tools.pass_timer import PassTimer
+
+
+PATH = Path("demo.vitte")
+
+SOURCE = """fn first(a: i32) -> i32
+  let x = a
+  return x
+.end
+
+fn second() -> i32
+  return 1
+.end
+"""
+
+
+class PassTimerTests(unittest.TestCase):
+    def test_disabled_timer_records_nothing(self) -> None:
+        timer = PassTimer(enabled=False)
+        with timer.phase("lex", "a.vitte"):
+            pass
+        self.assertEqual(timer.events, [])
+
+    def test_phases_are_recorded_in_order(self) -> None:
+        timer = PassTimer(enabled=True)
+        with timer.phase("lex", "a.vitte"):
+            pass
+        with timer.phase("parse", "a.vitte"):
+            pass
+        self.assertEqual([e.name for e in timer.events], ["lex", "parse"])
+        self.assertTrue(all(e.start_ns >= timer.origin_ns for e in timer.events))
+
+    def test_phase_is_recorded_when_body_raises(self) -> None:
+        timer = PassTimer(enabled=True)
+        with self.assertRaises(RuntimeError):
+            with timer.phase("codegen"):
+                raise RuntimeError("boom")
+        self.assertEqual([e.name for e in timer.events], ["codegen"])
+
+    def test_chrome_trace_is_complete_events(self) -> None:
+        timer = PassTimer(enabled=True)
+        with timer.phase("typecheck", 'm"1'):
+            pass
+        trace = json.loads(timer.chrome_trace())
+        (ev,) = trace["traceEvents"]
+        self.assertEqual(ev["ph"], "X")
+        self.assertEqual(ev["name"], "typecheck")
+        self.assertEqual(ev["args"]["module"], 'm"1')
+        self.assertEqual(set(ev["args"]), {"module", "allocs", "peak_bytes"})
+
+    def test_report_aggregates_per_phase(self) -> None:
+        timer = PassTimer(enabled=True)
+        for module in ("a", "b"):
+            with timer.phase("parse", module):
+                pass
+        lines = timer.report().splitlines()
+        self.assertTrue(lines[0].startswith("=== vittec --time-passes"))
+        (row,) = [l for l in lines if l.startswith("parse")]
+        self.assertEqual(row.split()[2], "2")
+        self.assertEqual(len(timer.report(verbose=True).splitlines()), len(lines) + 2)
+
+    def test_finish_writes_profile(self) -> None:
+        timer = PassTimer(enabled=True)
+        with timer.phase("lex"):
+            pass
+        with tempfile.TemporaryDirectory() as tmp:
+            out = Path(tmp) / "sub" / "trace.json"
+            timer.finish(False, out)
+            self.assertEqual(len(json.loads(out.read_text())["traceEvents"]), 1)
+
+
+class FrontendTimingTests(unittest.TestCase):
+    def test_database_records_frontend_phases(self) -> None:
+        db = FrontendDatabase()
+        db.timer = PassTimer(enabled=True)
+        db.set_source(PATH, SOURCE)
+        db.diagnostics(PATH)
+        names = [e.name for e in db.timer.events]
+        self.assertEqual(names[:2], ["lex", "parse"])
+        self.assertEqual(names.count("typecheck"), 2)
+
+    def test_memo_hit_records_nothing(self) -> None:
+        db = FrontendDatabase()
+        db.timer = PassTimer(enabled=True)
+        db.set_source(PATH, SOURCE)
+        db.diagnostics(PATH)
+        count = len(db.timer.events)
+        db.diagnostics(PATH)
+        self.assertEqual(len(db.timer.events), count)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,173 @@
+from __future__ import annotations
+
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+import unittest
+
+
+MAX_AUTO_JOBS = 32
+
+
+def worker_count(jobs: int, tasks: int) -> int:
+    n = jobs if jobs > 0 else min(tasks, MAX_AUTO_JOBS)
+    return max(n, 1)
+
+
+@dataclass
+class WorkDeque:
+    items: List[int] = field(default_factory=list)
+    head: int = 0
+
+    def __len__(self) -> int:
+        return len(self.items) - self.head
+
+    def push(self, task: int) -> None:
+        self.items.append(task)
+
+    def pop(self) -> Optional[int]:
+        if len(self) == 0:
+            return None
+        return self.items.pop()
+
+    def steal(self) -> Optional[int]:
+        if len(self) == 0:
+            return None
+        t = self.items[self.head]
+        self.head += 1
+        return t
+
+
+class Scheduler:
+    def __init__(self, workers: int) -> None:
+        self.deques = [WorkDeque() for _ in range(max(workers, 1))]
+        self.pending = 0
+        self.steals = 0
+
+    def is_idle(self) -> bool:
+        return self.pending == 0
+
+    def seed(self, tasks: List[int]) -> None:
+        n = len(self.deques)
+        per = (len(tasks) + n - 1) // n
+        for i in reversed(range(len(tasks))):
+            self.deques[i // per].push(tasks[i])
+        self.pending += len(tasks)
+
+    def next(self, w: int) -> Optional[int]:
+        own = self.deques[w].pop()
+        if own is not None:
+            self.pending -= 1
+            return own
+        n = len(self.deques)
+        for k in range(1, n):
+            stolen = self.deques[(w + k) % n].steal()
+            if stolen is not None:
+                self.pending -= 1
+                self.steals += 1
+                return stolen
+        return None
+
+    def claim_round(self) -> List[int]:
+        out = []
+        for w in range(len(self.deques)):
+            t = self.next(w)
+            if t is not None:
+                out.append(t)
+        return out
+
+
+def dependency_waves(names: List[str], imports: List[List[str]]) -> List[List[int]]:
+    n = len(names)
+    by_name = {name: i for i, name in enumerate(names)}
+    indegree = [0] * n
+    users: List[List[int]] = [[] for _ in range(n)]
+    for i in range(n):
+        seen = set()
+        for imp in imports[i]:
+            dep = by_name.get(imp)
+            if dep is None or dep == i or dep in seen:
+                continue
+            seen.add(dep)
+            users[dep].append(i)
+            indegree[i] += 1
+    waves = []
+    placed = 0
+    current = [i for i in range(n) if indegree[i] == 0]
+    while current:
+        waves.append(current)
+        placed += len(current)
+        nxt = []
+        for m in current:
+            for u in users[m]:
+                indegree[u] -= 1
+                if indegree[u] == 0:
+                    nxt.append(u)
+        current = sorted(nxt)
+    if placed < n:
+        waves.append([i for i in range(n) if indegree[i] > 0])
+    return waves
+
+
+def drain(sched: Scheduler) -> List[List[int]]:
+    rounds = []
+    while not sched.is_idle():
+        rounds.append(sched.claim_round())
+    return rounds
+
+
+class SchedulerTests(unittest.TestCase):
+    def test_every_task_runs_exactly_once(self) -> None:
+        for workers in (1, 2, 3, 7, 32):
+            for count in (0, 1, 5, 17, 64):
+                s = Scheduler(workers)
+                s.seed(list(range(count)))
+                done = [t for r in drain(s) for t in r]
+                self.assertEqual(sorted(done), list(range(count)), (workers, count))
+
+    def test_round_never_exceeds_worker_count(self) -> None:
+        s = Scheduler(4)
+        s.seed(list(range(10)))
+        for r in drain(s):
+            self.assertLessEqual(len(r), 4)
+            self.assertEqual(len(set(r)), len(r))
+
+    def test_blocks_are_contiguous_and_in_order(self) -> None:
+        s = Scheduler(2)
+        s.seed(list(range(6)))
+        self.assertEqual(s.claim_round(), [0, 3])
+        self.assertEqual(s.claim_round(), [1, 4])
+        self.assertEqual(s.steals, 0)
+
+    def test_idle_worker_steals_from_the_far_end(self) -> None:
+        s = Scheduler(3)
+        s.seed(list(range(3)))
+        s.deques[0].push(9)  # déséquilibre : worker 0 a deux tâches de plus
+        s.deques[0].push(8)
+        s.pending += 2
+        self.assertEqual(s.claim_round(), [8, 1, 2])
+        # workers 1 et 2 sont vides : ils volent la tête de la deque 0.
+        self.assertEqual(s.claim_round(), [9, 0])
+        self.assertEqual(s.steals, 1)
+        self.assertTrue(s.is_idle())
+
+    def test_worker_count(self) -> None:
+        self.assertEqual(worker_count(0, 0), 1)
+        self.assertEqual(worker_count(0, 5), 5)
+        self.assertEqual(worker_count(0, 600), MAX_AUTO_JOBS)
+        self.assertEqual(worker_count(4, 600), 4)
+
+
+class WaveTests(unittest.TestCase):
+    def test_waves_respect_imports(self) -> None:
+        names = ["app", "util", "core", "io"]
+        imports = [["util", "io", "std.fs"], ["core"], [], ["core"]]
+        self.assertEqual(dependency_waves(names, imports), [[2], [1, 3], [0]])
+
+    def test_cycle_goes_to_last_wave(self) -> None:
+        names = ["a", "b", "c"]
+        imports = [["b"], ["a"], []]
+        self.assertEqual(dependency_waves(names, imports), [[2], [0, 1]])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,65 @@
+from __future__ import annotations
+
+from pathlib import Path
+import re
+import unittest
+
+
+ROOT = Path(__file__).resolve().parents[2]
+LEXER = ROOT / "compiler" / "frontend" / "lexer.vitte"
+TOKENS = ROOT / "compiler" / "frontend" / "tokens.vitte"
+
+KW_TABLE_SIZE = 32
+
+
+def keyword_hash(word: str) -> int:
+    b = word.encode()
+    return (13 * b[0] + 9 * b[1] + b[-1] + 2 * len(b)) & (KW_TABLE_SIZE - 1)
+
+
+def declared_keywords() -> dict:
+    """Mots-clés déclarés dans tokens.vitte (push_keyword_info)."""
+    pat = re.compile(r'push_keyword_info\(&mut items, lex\.TokenKind\.(\w+), "([^"]+)"')
+    return {text: kind for kind, text in pat.findall(TOKENS.read_text(encoding="utf-8"))}
+
+
+def lexer_table() -> dict:
+    """Cases remplies par keyword_table() dans lexer.vitte."""
+    pat = re.compile(r'table\[(\d+)\] = KeywordSlot\(text = "([^"]+)", kind = TokenKind\.(\w+)\)')
+    return {int(slot): (text, kind) for slot, text, kind in pat.findall(LEXER.read_text(encoding="utf-8"))}
+
+
+def classify(table: dict, word: str) -> str:
+    if len(word) < 2 or len(word) > 8:
+        return "Ident"
+    slot = table.get(keyword_hash(word))
+    if slot is None or slot[0] != word:
+        return "Ident"
+    return slot[1]
+
+
+class KeywordHashTests(unittest.TestCase):
+    def test_hash_is_perfect_on_declared_keywords(self) -> None:
+        words = list(declared_keywords())
+        self.assertEqual(len(words), 20)
+        slots = [keyword_hash(w) for w in words]
+        self.assertEqual(len(set(slots)), len(slots))
+
+    def test_lexer_table_matches_tokens_vitte(self) -> None:
+        table = lexer_table()
+        declared = declared_keywords()
+        self.assertEqual({t: k for t, k in table.values()}, declared)
+        for slot, (text, _) in table.items():
+            self.assertEqual(keyword_hash(text), slot, text)
+            self.assertTrue(2 <= len(text) <= 8, text)
+
+    def test_classify_rejects_near_misses(self) -> None:
+        table = lexer_table()
+        self.assertEqual(classify(table, "while"), "KwWhile")
+        self.assertEqual(classify(table, "fn"), "KwFn")
+        for word in ("whiles", "fnx", "Module", "e", "en", "pipelines", "return", "_"):
+            self.assertEqual(classify(table, word), "Ident", word)
+
+
+if __name__ == "__main__":
+    unittest.main()
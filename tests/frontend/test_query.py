@@ -0,0 +1,79 @@
+from __future__ import annotations
+
+from pathlib import Path
+import unittest
+
+from tools.frontend_host import FrontendDatabase
+
+
+PATH = Path("demo.vitte")
+
+SOURCE = """struct Point
+.end
+
+fn first(a: i32) -> i32
+  let x = a
+  return y
+.end
+
+fn second() -> i32
+  let p = Point { }
+  return 1
+.end
+"""
+
+
+def checked(db: FrontendDatabase) -> list:
+    return [k[2] for k in db.executed if k[0] == "typecheck_fn"]
+
+
+def summary(db: FrontendDatabase) -> list:
+    return [(d.code, d.span.line, d.message) for d in db.diagnostics(PATH)]
+
+
+class QueryEngineTests(unittest.TestCase):
+    def setUp(self) -> None:
+        self.db = FrontendDatabase()
+        self.db.set_source(PATH, SOURCE)
+        self.first = summary(self.db)
+        self.db.executed.clear()
+
+    def test_initial_diagnostics(self) -> None:
+        self.assertIn(("E7102", 6, "unresolved identifier `y`"), self.first)
+
+    def test_unchanged_source_recomputes_nothing(self) -> None:
+        self.db.set_source(PATH, SOURCE)
+        self.assertEqual(summary(self.db), self.first)
+        self.assertEqual(self.db.executed, [])
+
+    def test_body_edit_rechecks_only_that_function(self) -> None:
+        self.db.set_source(PATH, SOURCE.replace("return y", "return x"))
+        diags = summary(self.db)
+        self.assertEqual(checked(self.db), ["first#0"])
+        self.assertNotIn(("E7102", 6, "unresolved identifier `y`"), diags)
+
+    def test_line_shift_reuses_function_results(self) -> None:
+        self.db.set_source(PATH, "# en-tête\n" + SOURCE)
+        diags = summary(self.db)
+        self.assertEqual(checked(self.db), [])
+        self.assertIn(("E7102", 7, "unresolved identifier `y`"), diags)
+
+    def test_struct_change_rechecks_every_function(self) -> None:
+        self.db.set_source(PATH, SOURCE.replace("struct Point", "struct Pt"))
+        summary(self.db)
+        self.assertEqual(sorted(checked(self.db)), ["first#0", "second#0"])
+
+    def test_signature_query_ignores_bodies(self) -> None:
+        sig = self.db.item_signature(PATH, "first#0")
+        self.db.set_source(PATH, SOURCE.replace("let x = a", "let x = 2"))
+        self.assertEqual(self.db.item_signature(PATH, "first#0"), sig)
+        self.assertEqual(sig, ("first", (("a", "i32"),), "i32"))
+
+    def test_returned_diagnostics_are_copies(self) -> None:
+        for d in self.db.diagnostics(PATH):
+            d.code = "E0000"
+        self.assertEqual(summary(self.db), self.first)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,149 @@
+from __future__ import annotations
+
+from dataclasses import dataclass, field
+from typing import Dict, List
+import unittest
+
+
+SYNTHETIC_FILE = 0
+NO_OFFSET = 0xFFFFFFFF
+
+
+@dataclass(frozen=True)
+class Span:
+    file: int
+    offset: int
+    length: int
+
+    @staticmethod
+    def dummy(file: int) -> "Span":
+        return Span(file, NO_OFFSET, 0)
+
+    @staticmethod
+    def synthetic() -> "Span":
+        return Span.dummy(SYNTHETIC_FILE)
+
+    def is_dummy(self) -> bool:
+        return self.offset == NO_OFFSET
+
+    def end_offset(self) -> int:
+        return self.offset + self.length
+
+    def merge(self, other: "Span") -> "Span":
+        if self.file != other.file or other.is_dummy():
+            return self
+        if self.is_dummy():
+            return other
+        start = min(self.offset, other.offset)
+        stop = max(self.end_offset(), other.end_offset())
+        return Span(self.file, start, stop - start)
+
+
+@dataclass
+class SourceMap:
+    paths: List[str] = field(default_factory=lambda: ["<synthetic>"])
+    ids: Dict[str, int] = field(default_factory=dict)
+    line_starts: List[List[int]] = field(default_factory=lambda: [[]])
+
+    def file_id(self, path: str) -> int:
+        if path in self.ids:
+            return self.ids[path]
+        fid = len(self.paths)
+        self.paths.append(path)
+        self.line_starts.append([])
+        self.ids[path] = fid
+        return fid
+
+    def add_file(self, path: str, text: str) -> int:
+        fid = self.file_id(path)
+        starts = [0]
+        for i, ch in enumerate(text):
+            if ch == "\n":
+                starts.append(i + 1)
+        self.line_starts[fid] = starts
+        return fid
+
+    def line_col(self, file: int, offset: int) -> tuple:
+        if offset == NO_OFFSET or file >= len(self.line_starts):
+            return (0, 0)
+        starts = self.line_starts[file]
+        if not starts:
+            return (0, 0)
+        lo, hi = 0, len(starts) - 1
+        while lo < hi:
+            mid = (lo + hi + 1) // 2
+            if starts[mid] <= offset:
+                lo = mid
+            else:
+                hi = mid - 1
+        return (lo + 1, offset - starts[lo] + 1)
+
+    def end_of(self, span: Span) -> tuple:
+        if span.length == 0:
+            return self.line_col(span.file, span.offset)
+        return self.line_col(span.file, span.offset + span.length - 1)
+
+    def span_at(self, path: str, line: int, col: int) -> Span:
+        fid = self.file_id(path)
+        starts = self.line_starts[fid]
+        if line < 1 or line > len(starts) or col < 1:
+            return Span.dummy(fid)
+        return Span(fid, starts[line - 1] + col - 1, 1)
+
+    def location(self, span: Span) -> str:
+        line, col = self.line_col(span.file, span.offset)
+        return f"{self.paths[span.file]}:{line}:{col}"
+
+
+class SourceMapTests(unittest.TestCase):
+    TEXT = "fn main()\n  let x = 1\n\n  x\n"
+
+    def test_ids_are_stable_and_reserve_synthetic(self) -> None:
+        sm = SourceMap()
+        a = sm.add_file("a.vitte", self.TEXT)
+        b = sm.file_id("b.vitte")
+        self.assertEqual(a, 1)
+        self.assertEqual(b, 2)
+        self.assertEqual(sm.file_id("a.vitte"), a)
+        self.assertEqual(Span.synthetic().file, SYNTHETIC_FILE)
+
+    def test_line_col_from_offsets(self) -> None:
+        sm = SourceMap()
+        fid = sm.add_file("a.vitte", self.TEXT)
+        self.assertEqual(sm.line_col(fid, 0), (1, 1))
+        self.assertEqual(sm.line_col(fid, 9), (1, 10))  # '\n' de la ligne 1
+        self.assertEqual(sm.line_col(fid, 10), (2, 1))
+        self.assertEqual(sm.line_col(fid, 16), (2, 7))  # 'x'
+        self.assertEqual(sm.line_col(fid, 22), (3, 1))  # ligne vide
+        self.assertEqual(sm.line_col(fid, 25), (4, 3))
+
+    def test_unknown_text_and_dummy_resolve_to_zero(self) -> None:
+        sm = SourceMap()
+        fid = sm.file_id("nofile.vitte")
+        self.assertEqual(sm.line_col(fid, 3), (0, 0))
+        self.assertEqual(sm.line_col(fid, NO_OFFSET), (0, 0))
+        self.assertEqual(sm.location(Span.synthetic()), "<synthetic>:0:0")
+
+    def test_span_at_round_trips(self) -> None:
+        sm = SourceMap()
+        sm.add_file("a.vitte", self.TEXT)
+        span = sm.span_at("a.vitte", 2, 7)
+        self.assertEqual(span.offset, 16)
+        self.assertEqual(sm.location(span), "a.vitte:2:7")
+        self.assertTrue(sm.span_at("a.vitte", 9, 1).is_dummy())
+
+    def test_merge_is_envelope(self) -> None:
+        sm = SourceMap()
+        fid = sm.add_file("a.vitte", self.TEXT)
+        a = Span(fid, 12, 3)
+        b = Span(fid, 20, 4)
+        m = a.merge(b)
+        self.assertEqual((m.offset, m.length), (12, 12))
+        self.assertEqual(b.merge(a), m)
+        self.assertEqual(sm.end_of(m), (4, 1))
+        self.assertEqual(Span.dummy(fid).merge(a), a)
+        self.assertEqual(a.merge(Span(fid + 1, 0, 1)), a)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,204 @@
+from __future__ import annotations
+
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+import unittest
+
+
+# Miroir de compiler/sema/types.vitte et de l'InferCtx de typecheck.vitte.
+
+UNIT, BOOL, I64, STR = 0, 1, 2, 3
+NO_TYPE = 0xFFFFFFFF
+
+
+@dataclass
+class TyData:
+    kind: str
+    name: str = ""
+    items: Tuple[int, ...] = ()
+
+
+class TypeInterner:
+    def __init__(self) -> None:
+        self.types: List[TyData] = []
+        self.ids_by_key: Dict[str, int] = {}
+        self.parent: List[int] = []
+        self.rank: List[int] = []
+        for kind in ("unit", "bool", "i64", "str"):
+            self._add(TyData(kind))
+        self.primitive_ids_by_name = {"unit": UNIT, "bool": BOOL, "i64": I64, "str": STR}
+
+    def _add(self, data: TyData) -> int:
+        tid = len(self.types)
+        self.types.append(data)
+        self.parent.append(tid)
+        self.rank.append(0)
+        return tid
+
+    def _intern(self, key: str, data: TyData) -> int:
+        if key not in self.ids_by_key:
+            self.ids_by_key[key] = self._add(data)
+        return self.ids_by_key[key]
+
+    def named(self, name: str) -> int:
+        if name in self.primitive_ids_by_name:
+            return self.primitive_ids_by_name[name]
+        return self._intern("N:" + name, TyData("named", name))
+
+    def tuple(self, items: List[int]) -> int:
+        key = "T:" + "".join(f"{i}," for i in items)
+        return self._intern(key, TyData("tuple", items=tuple(items)))
+
+    def fresh_var(self) -> int:
+        return self._add(TyData("var"))
+
+    def find(self, t: int) -> int:
+        root = t
+        while self.parent[root] != root:
+            root = self.parent[root]
+        while self.parent[t] != root:
+            self.parent[t], t = root, self.parent[t]
+        return root
+
+    def occurs(self, var: int, t: int) -> bool:
+        r = self.find(t)
+        if r == var:
+            return True
+        if self.types[r].kind != "tuple":
+            return False
+        return any(self.occurs(var, it) for it in self.types[r].items)
+
+    def unify(self, a: int, b: int) -> bool:
+        ra, rb = self.find(a), self.find(b)
+        if ra == rb:
+            return True
+        ka, kb = self.types[ra].kind, self.types[rb].kind
+        if ka == "var" and kb == "var":
+            if self.rank[ra] < self.rank[rb]:
+                self.parent[ra] = rb
+            elif self.rank[ra] > self.rank[rb]:
+                self.parent[rb] = ra
+            else:
+                self.parent[rb] = ra
+                self.rank[ra] += 1
+            return True
+        if ka == "var":
+            if self.occurs(ra, rb):
+                return False
+            self.parent[ra] = rb
+            return True
+        if kb == "var":
+            if self.occurs(rb, ra):
+                return False
+            self.parent[rb] = ra
+            return True
+        if ka != "tuple" or kb != "tuple":
+            return False
+        xs, ys = self.types[ra].items, self.types[rb].items
+        if len(xs) != len(ys):
+            return False
+        return all(self.unify(x, y) for x, y in zip(xs, ys))
+
+    def show(self, t: int) -> str:
+        d = self.types[self.find(t)]
+        if d.kind == "tuple":
+            return "(" + ",".join(self.show(i) for i in d.items) + ")"
+        if d.kind == "named":
+            return d.name
+        return "_" if d.kind == "var" else d.kind
+
+
+@dataclass
+class InferCtx:
+    slots: Dict[str, int] = field(default_factory=dict)
+    env: List[int] = field(default_factory=list)
+    trail: List[Tuple[int, int]] = field(default_factory=list)
+
+    def bind(self, name: str, ty: int) -> None:
+        if name not in self.slots:
+            self.slots[name] = len(self.env)
+            self.env.append(NO_TYPE)
+        slot = self.slots[name]
+        self.trail.append((slot, self.env[slot]))
+        self.env[slot] = ty
+
+    def lookup(self, name: str) -> Optional[int]:
+        slot = self.slots.get(name)
+        if slot is None or self.env[slot] == NO_TYPE:
+            return None
+        return self.env[slot]
+
+    def restore(self, mark: int) -> None:
+        while len(self.trail) > mark:
+            slot, prev = self.trail.pop()
+            self.env[slot] = prev
+
+
+class InternerTests(unittest.TestCase):
+    def test_hash_consing_gives_one_id_per_type(self) -> None:
+        t = TypeInterner()
+        a = t.tuple([I64, t.named("Point")])
+        b = t.tuple([t.named("i64"), t.named("Point")])
+        self.assertEqual(a, b)
+        self.assertNotEqual(a, t.tuple([t.named("Point"), I64]))
+        self.assertEqual(t.named("bool"), BOOL)
+
+    def test_vars_are_never_shared(self) -> None:
+        t = TypeInterner()
+        self.assertNotEqual(t.fresh_var(), t.fresh_var())
+
+
+class UnifyTests(unittest.TestCase):
+    def test_var_binds_to_concrete(self) -> None:
+        t = TypeInterner()
+        v = t.fresh_var()
+        self.assertTrue(t.unify(v, I64))
+        self.assertEqual(t.find(v), I64)
+        self.assertFalse(t.unify(v, BOOL))
+
+    def test_var_chain_resolves_through_union_find(self) -> None:
+        t = TypeInterner()
+        vs = [t.fresh_var() for _ in range(50)]
+        for a, b in zip(vs, vs[1:]):
+            self.assertTrue(t.unify(a, b))
+        self.assertTrue(t.unify(vs[-1], STR))
+        self.assertTrue(all(t.find(v) == STR for v in vs))
+        self.assertLessEqual(max(t.rank), 6)  # union par rang : profondeur log
+
+    def test_tuples_unify_componentwise(self) -> None:
+        t = TypeInterner()
+        v = t.fresh_var()
+        self.assertTrue(t.unify(t.tuple([v, BOOL]), t.tuple([I64, BOOL])))
+        self.assertEqual(t.show(v), "i64")
+        self.assertFalse(t.unify(t.tuple([I64]), t.tuple([I64, I64])))
+
+    def test_occurs_check(self) -> None:
+        t = TypeInterner()
+        v = t.fresh_var()
+        self.assertFalse(t.unify(v, t.tuple([v, I64])))
+        self.assertEqual(t.show(v), "_")
+
+
+class ScopeTests(unittest.TestCase):
+    def test_block_restores_shadowed_bindings(self) -> None:
+        ctx = InferCtx()
+        ctx.bind("x", I64)
+        mark = len(ctx.trail)
+        ctx.bind("x", BOOL)
+        ctx.bind("y", STR)
+        self.assertEqual(ctx.lookup("x"), BOOL)
+        ctx.restore(mark)
+        self.assertEqual(ctx.lookup("x"), I64)
+        self.assertIsNone(ctx.lookup("y"))
+
+    def test_env_work_is_linear_in_statements(self) -> None:
+        # Une liaison = une entrée de trail ; aucune copie d'environnement.
+        ctx = InferCtx()
+        for i in range(1000):
+            ctx.bind(f"v{i}", I64)
+        self.assertEqual(len(ctx.trail), 1000)
+        self.assertEqual(len(ctx.env), 1000)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,404 @@
+from __future__ import annotations
+
+from dataclasses import replace
+from typing import Dict, List, Optional, Tuple
+import unittest
+
+from tests.ir.test_ir_dump import (
+    BinOp,
+    Block,
+    BlockId,
+    Function,
+    Instr,
+    InstrTag,
+    Module,
+    Param,
+    Program,
+    Terminator,
+    Type,
+    TypeKind,
+    ValueId,
+)
+from tests.ir.test_ir_opt import (
+    bin_,
+    br,
+    check_ssa,
+    ci,
+    function,
+    jump,
+    operands,
+    optimize_module,
+    phi,
+    ret,
+    rewrite_function,
+    successors,
+    term_operands,
+)
+
+
+# Python mirror of compiler/ir/ir_inline.vitte.
+
+CALL_COST = 5
+CONST_ARG_BONUS = 2
+POLICIES = {"O0": (0, 0, False), "O1": (8, 2, False), "O2": (24, 3, True)}
+SPECIALIZE_MAX_COST = 64
+MAX_CALLER_COST = 2000
+FREE = (InstrTag.CONST_INT, InstrTag.CONST_BOOL, InstrTag.CONST_STRING, InstrTag.PARAM, InstrTag.PHI)
+
+
+def inline_cost(f: Function) -> int:
+    cost = len(f.blocks) - 1 if f.blocks else 0
+    for b in f.blocks:
+        for i in b.instrs:
+            cost += 0 if i.tag in FREE else CALL_COST if i.tag is InstrTag.CALL else 1
+    return cost
+
+
+def calls(f: Function, only: str = "") -> bool:
+    return any(i.tag is InstrTag.CALL and (only == "" or i.callee == only) for b in f.blocks for i in b.instrs)
+
+
+def value_used(f: Function, v: ValueId) -> bool:
+    return any(v.raw == o.raw for b in f.blocks for i in b.instrs for o in operands(i)) or any(
+        v.raw == o.raw for b in f.blocks for o in term_operands(b))
+
+
+def entry_is_free(f: Function) -> bool:
+    return all(s.raw != f.entry.raw for b in f.blocks for s in successors(b))
+
+
+def count_returns(f: Function) -> Tuple[int, int]:
+    rets = [b.terminator for b in f.blocks if b.terminator is not None and b.terminator.kind == "return"]
+    return sum(1 for t in rets if t.value is not None), sum(1 for t in rets if t.value is None)
+
+
+def next_value_raw(f: Function) -> int:
+    return max([p.value.raw + 1 for p in f.params] + [i.result.raw + 1 for b in f.blocks for i in b.instrs] + [0])
+
+
+def next_block_raw(f: Function) -> int:
+    return max([b.id.raw + 1 for b in f.blocks] + [0])
+
+
+def rename_phi_source(b: Block, src: BlockId, dst: BlockId) -> Block:
+    return replace(b, instrs=[
+        replace(i, incomings=[(dst if p.raw == src.raw else p, v) for p, v in i.incomings]) if i.tag is InstrTag.PHI else i
+        for i in b.instrs
+    ])
+
+
+def inline_call(caller: Function, bi: int, ii: int, callee: Function, args: List[ValueId]) -> Function:
+    b = caller.blocks[bi]
+    call = b.instrs[ii]
+    v_off, b_off = next_value_raw(caller), next_block_raw(caller)
+    cont_id = BlockId(b_off + next_block_raw(callee))
+    params: Dict[int, ValueId] = {p.value.raw: args[k] for k, p in enumerate(callee.params)}
+    for cb in callee.blocks:
+        for inst in cb.instrs:
+            if inst.tag is InstrTag.PARAM:
+                params[inst.result.raw] = args[int(inst.value)]
+    mv = lambda v: params.get(v.raw, ValueId(v.raw + v_off))
+    mb = lambda t: BlockId(t.raw + b_off)
+    cloned: List[Block] = []
+    returns: List[Tuple[BlockId, ValueId]] = []
+    for cb in callee.blocks:
+        bid = mb(cb.id)
+        instrs = []
+        for inst in cb.instrs:
+            if inst.result.raw in params:
+                continue
+            new = replace(inst, result=mv(inst.result))
+            if inst.tag is InstrTag.BINOP:
+                new = replace(new, lhs=mv(inst.lhs), rhs=mv(inst.rhs))
+            elif inst.tag is InstrTag.UNOP:
+                new = replace(new, operand=mv(inst.operand))
+            elif inst.tag is InstrTag.CALL:
+                new = replace(new, args=[mv(v) for v in inst.args])
+            elif inst.tag is InstrTag.MAKE_TUPLE:
+                new = replace(new, items=[mv(v) for v in inst.items])
+            elif inst.tag is InstrTag.PHI:
+                new = replace(new, incomings=[(mb(p), mv(v)) for p, v in inst.incomings])
+            instrs.append(new)
+        t = cb.terminator
+        if t.kind == "return":
+            if t.value is not None:
+                returns.append((bid, mv(t.value)))
+            term = Terminator(kind="jump", target=cont_id)
+        elif t.kind == "jump":
+            term = Terminator(kind="jump", target=mb(t.target))
+        else:
+            term = Terminator(kind="cond_jump", value=mv(t.value), then_tgt=mb(t.then_tgt), else_tgt=mb(t.else_tgt))
+        cloned.append(Block(bid, callee.name + "." + cb.name, instrs, term))
+    alias: Dict[int, ValueId] = {}
+    cont_instrs: List[Instr] = []
+    if len(returns) == 1:
+        alias[call.result.raw] = returns[0][1]
+    elif len(returns) > 1:
+        cont_instrs.append(Instr(tag=InstrTag.PHI, result=call.result, ty=call.ty, incomings=returns))
+    cont_instrs += b.instrs[ii + 1:]
+    head = replace(b, instrs=b.instrs[:ii], terminator=Terminator(kind="jump", target=mb(callee.entry)))
+    cont = Block(cont_id, b.name + ".cont", cont_instrs, b.terminator)
+    blocks: List[Block] = []
+    for k, blk in enumerate(caller.blocks):
+        if k == bi:
+            blocks += [rename_phi_source(head, b.id, cont_id)] + cloned + [rename_phi_source(cont, b.id, cont_id)]
+        else:
+            blocks.append(rename_phi_source(blk, b.id, cont_id))
+    return rewrite_function(replace(caller, blocks=blocks), alias)
+
+
+def const_args(f: Function, args: List[ValueId]) -> Dict[int, Instr]:
+    defs = {i.result.raw: i for b in f.blocks for i in b.instrs
+            if (i.tag is InstrTag.CONST_INT and i.ty.kind is TypeKind.I64) or i.tag is InstrTag.CONST_BOOL}
+    return {a: defs[v.raw] for a, v in enumerate(args) if v.raw in defs}
+
+
+def const_matches(inst: Instr, p: Param) -> bool:
+    return p.ty.kind is (TypeKind.I64 if inst.tag is InstrTag.CONST_INT else TypeKind.BOOL)
+
+
+def const_text(inst: Instr) -> str:
+    return inst.value if inst.tag is InstrTag.CONST_INT else ("true" if inst.bool_value else "false")
+
+
+def specialize(callee: Function, consts: Dict[int, Instr], clones: Dict[str, Function]) -> str:
+    dropped = {p: c for p, c in consts.items() if const_matches(c, callee.params[p])}
+    name = callee.name + ".spec" + "".join(f".{p}_{const_text(c)}" for p, c in sorted(dropped.items()))
+    if name in clones:
+        return name
+    defs = [replace(dropped[p], result=callee.params[p].value, ty=callee.params[p].ty) for p in sorted(dropped)]
+    params = [p for k, p in enumerate(callee.params) if k not in dropped]
+    blocks = [replace(b, instrs=(defs if b.id.raw == callee.entry.raw else []) + b.instrs) for b in callee.blocks]
+    clones[name] = replace(callee, name=name, params=params, blocks=blocks)
+    return name
+
+
+def inline_program(prog: Program, level: str) -> Tuple[Program, List[Tuple[str, str, str]]]:
+    max_cost, max_depth, spec = POLICIES[level]
+    records: List[Tuple[str, str, str]] = []
+    if max_depth == 0:
+        return prog, records
+    seen: Dict[str, Tuple[int, int]] = {}
+    ambiguous = set()
+    for mi, m in enumerate(prog.modules):
+        for fi, f in enumerate(m.functions):
+            if f.name in seen:
+                ambiguous.add(f.name)
+            else:
+                seen[f.name] = (mi, fi)
+    unique = {n: r for n, r in seen.items() if n not in ambiguous}
+    modules = []
+    for mi, m in enumerate(prog.modules):
+        local = {f.name: (mi, fi) for fi, f in enumerate(m.functions)}
+        clones: Dict[str, Function] = {}
+        funcs = []
+        for f in m.functions:
+            cur = f
+            for _ in range(max_depth):
+                pending = {i.result.raw for b in cur.blocks for i in b.instrs if i.tag is InstrTag.CALL}
+                changed = False
+                while True:
+                    site = next(((bi, ii) for bi, b in enumerate(cur.blocks) for ii, i in enumerate(b.instrs)
+                                 if i.result.raw in pending), None)
+                    if site is None:
+                        break
+                    bi, ii = site
+                    call = cur.blocks[bi].instrs[ii]
+                    pending.discard(call.result.raw)
+                    ref = local.get(call.callee, unique.get(call.callee))
+                    if ref is None:
+                        continue
+                    callee = prog.modules[ref[0]].functions[ref[1]]
+                    if (callee.name == cur.name or not callee.blocks or len(callee.params) != len(call.args)
+                            or calls(callee, callee.name) or (ref[0] != mi and calls(callee))):
+                        continue
+                    consts = const_args(cur, call.args)
+                    raw = inline_cost(callee)
+                    cost = max(raw - CONST_ARG_BONUS * len(consts), 0)
+                    rv, rn = count_returns(callee)
+                    shape = entry_is_free(callee) and rv + rn > 0 and (rn == 0 or (rv == 0 and not value_used(cur, call.result)))
+                    if cost <= max_cost and shape and inline_cost(cur) + raw <= MAX_CALLER_COST:
+                        cur = inline_call(cur, bi, ii, callee, call.args)
+                        records.append((f.name, call.callee, ""))
+                        changed = True
+                    elif spec and consts and raw <= SPECIALIZE_MAX_COST:
+                        name = specialize(callee, consts, clones)
+                        kept = [v for a, v in enumerate(call.args) if not (a in consts and const_matches(consts[a], callee.params[a]))]
+                        instrs = list(cur.blocks[bi].instrs)
+                        instrs[ii] = replace(call, callee=name, args=kept)
+                        blocks = list(cur.blocks)
+                        blocks[bi] = replace(blocks[bi], instrs=instrs)
+                        cur = replace(cur, blocks=blocks)
+                        records.append((f.name, call.callee, name))
+                        changed = True
+                if not changed:
+                    break
+            funcs.append(cur)
+        modules.append(Module(m.name, funcs + list(clones.values())))
+    return Program(modules), records
+
+
+# Petit interpréteur pour vérifier que l’inlining préserve la sémantique.
+def run(prog: Program, name: str, args: List[int]) -> object:
+    funcs = {f.name: f for m in prog.modules for f in m.functions}
+    f = funcs[name]
+    env: Dict[int, object] = {p.value.raw: a for p, a in zip(f.params, args)}
+    blocks = {b.id.raw: b for b in f.blocks}
+    prev: Optional[int] = None
+    cur = blocks[f.entry.raw]
+    ops = {
+        BinOp.ADD: lambda a, b: a + b, BinOp.SUB: lambda a, b: a - b, BinOp.MUL: lambda a, b: a * b,
+        BinOp.LT: lambda a, b: a < b, BinOp.GT: lambda a, b: a > b, BinOp.LE: lambda a, b: a <= b,
+        BinOp.GE: lambda a, b: a >= b, BinOp.EQ: lambda a, b: a == b, BinOp.NE: lambda a, b: a != b,
+    }
+    for _ in range(10000):
+        phis = {i.result.raw: env[dict((p.raw, v) for p, v in i.incomings)[prev].raw]
+                for i in cur.instrs if i.tag is InstrTag.PHI}
+        env.update(phis)
+        for i in cur.instrs:
+            if i.tag is InstrTag.CONST_INT:
+                env[i.result.raw] = int(i.value)
+            elif i.tag is InstrTag.CONST_BOOL:
+                env[i.result.raw] = i.bool_value
+            elif i.tag is InstrTag.BINOP:
+                env[i.result.raw] = ops[i.binop](env[i.lhs.raw], env[i.rhs.raw])
+            elif i.tag is InstrTag.CALL:
+                env[i.result.raw] = run(prog, i.callee, [env[v.raw] for v in i.args])
+        t = cur.terminator
+        if t.kind == "return":
+            return env[t.value.raw] if t.value is not None else None
+        prev = cur.id.raw
+        if t.kind == "jump":
+            cur = blocks[t.target.raw]
+        else:
+            cur = blocks[(t.then_tgt if env[t.value.raw] else t.else_tgt).raw]
+    raise AssertionError("no return")
+
+
+def i64(name: str, v: int) -> Param:
+    return Param(name, Type.i64(), ValueId(v))
+
+
+def call(v: int, callee: str, *args: int) -> Instr:
+    return Instr(tag=InstrTag.CALL, result=ValueId(v), ty=Type.i64(), callee=callee, args=[ValueId(a) for a in args])
+
+
+def min_i64() -> Function:
+    # if a < b { ret a } else { ret b }
+    return function("min_i64", [i64("a", 0), i64("b", 1)], [
+        Block(BlockId(0), "entry", [bin_(2, BinOp.LT, 0, 1)], br(2, 1, 2)),
+        Block(BlockId(1), "then", [], ret(0)),
+        Block(BlockId(2), "else", [], ret(1)),
+    ])
+
+
+def abs_i64() -> Function:
+    return function("abs_i64", [i64("x", 0)], [
+        Block(BlockId(0), "entry", [ci(1, "0"), bin_(2, BinOp.LT, 0, 1)], br(2, 1, 2)),
+        Block(BlockId(1), "neg", [bin_(3, BinOp.SUB, 1, 0)], ret(3)),
+        Block(BlockId(2), "pos", [], ret(0)),
+    ])
+
+
+def clamped_sum() -> Function:
+    # s = 0 ; i = 0 ; while i < n { s = s + min_i64(i, 5) ; i = i + 1 } ; ret s
+    return function("clamped_sum", [i64("n", 0)], [
+        Block(BlockId(0), "entry", [ci(1, "0"), ci(2, "5"), ci(3, "1")], jump(1)),
+        Block(BlockId(1), "head", [phi(4, (0, 1), (2, 7)), phi(5, (0, 1), (2, 8)), bin_(6, BinOp.LT, 5, 0)], br(6, 2, 3)),
+        Block(BlockId(2), "body", [call(9, "min_i64", 5, 2), bin_(7, BinOp.ADD, 4, 9), bin_(8, BinOp.ADD, 5, 3)], jump(1)),
+        Block(BlockId(3), "exit", [], ret(4)),
+    ])
+
+
+def poly() -> Function:
+    # x*k + x*x*k + ... : trop gros pour être recopié (coût > 24).
+    instrs = [bin_(2, BinOp.MUL, 0, 1)]
+    nxt = 3
+    for _ in range(13):
+        instrs.append(bin_(nxt, BinOp.MUL, nxt - 1, 0))
+        instrs.append(bin_(nxt + 1, BinOp.ADD, nxt, 1))
+        nxt += 2
+    return function("poly", [i64("x", 0), i64("k", 1)], [Block(BlockId(0), "entry", instrs, ret(nxt - 1))])
+
+
+def count_calls(prog: Program) -> int:
+    return sum(1 for m in prog.modules for f in m.functions for b in f.blocks for i in b.instrs if i.tag is InstrTag.CALL)
+
+
+class IrInlineTest(unittest.TestCase):
+    def test_o0_keeps_every_call(self) -> None:
+        prog = Program([Module("m", [min_i64(), clamped_sum()])])
+        out, records = inline_program(prog, "O0")
+        self.assertEqual(out, prog)
+        self.assertEqual(records, [])
+
+    def test_helper_with_two_returns_is_inlined_into_the_loop(self) -> None:
+        prog = Program([Module("m", [min_i64(), clamped_sum()])])
+        out, records = inline_program(prog, "O1")
+        self.assertEqual(records, [("clamped_sum", "min_i64", "")])
+        caller = out.modules[0].functions[1]
+        check_ssa(caller)
+        self.assertFalse(calls(caller))
+        names = [b.name for b in caller.blocks]
+        self.assertEqual(names[:6], ["entry", "head", "body", "min_i64.entry", "min_i64.then", "min_i64.else"])
+        self.assertEqual(names[6], "body.cont")
+        # Le latch de la boucle est désormais la suite : les phis de l’en-tête la citent.
+        head = caller.blocks[1]
+        self.assertEqual({p.raw for p, _ in head.instrs[0].incomings}, {0, caller.blocks[6].id.raw})
+        self.assertEqual(caller.blocks[6].instrs[0].tag, InstrTag.PHI)
+        for n in (0, 3, 9):
+            self.assertEqual(run(out, "clamped_sum", [n]), run(prog, "clamped_sum", [n]))
+        opt, _ = optimize_module(out.modules[0], "O1")
+        check_ssa(opt.functions[1])
+        self.assertEqual(run(Program([opt]), "clamped_sum", [9]), sum(min(i, 5) for i in range(9)))
+
+    def test_leaf_helper_is_inlined_across_modules_but_not_a_caller(self) -> None:
+        user = function("dist", [i64("a", 0), i64("b", 1)], [
+            Block(BlockId(0), "entry", [bin_(2, BinOp.SUB, 0, 1), call(3, "abs_i64", 2)], ret(3)),
+        ])
+        wrapper = function("wrapped_abs", [i64("x", 0)], [Block(BlockId(0), "entry", [call(1, "abs_i64", 0)], ret(1))])
+        app = function("app", [i64("a", 0)], [
+            Block(BlockId(0), "entry", [call(1, "wrapped_abs", 0), call(2, "dist", 0, 1)], ret(2)),
+        ])
+        prog = Program([Module("jmath", [abs_i64(), wrapper]), Module("geo", [user]), Module("app", [app])])
+        out, records = inline_program(prog, "O1")
+        self.assertIn(("dist", "abs_i64", ""), records)
+        self.assertFalse(calls(out.modules[1].functions[0]))
+        self.assertEqual(run(out, "dist", [3, 10]), 7)
+        # wrapped_abs et dist (corps d’origine) appellent abs_i64 : hors module, ils restent des appels.
+        app_out = out.modules[2].functions[0]
+        self.assertEqual([i.callee for b in app_out.blocks for i in b.instrs if i.tag is InstrTag.CALL], ["wrapped_abs", "dist"])
+        check_ssa(app_out)
+
+    def test_recursive_functions_are_not_inlined(self) -> None:
+        fact = function("fact", [i64("n", 0)], [
+            Block(BlockId(0), "entry", [ci(1, "1"), bin_(2, BinOp.LE, 0, 1)], br(2, 1, 2)),
+            Block(BlockId(1), "base", [], ret(1)),
+            Block(BlockId(2), "rec", [bin_(3, BinOp.SUB, 0, 1), call(4, "fact", 3), bin_(5, BinOp.MUL, 0, 4)], ret(5)),
+        ])
+        main = function("main", [], [Block(BlockId(0), "entry", [ci(0, "5"), call(1, "fact", 0)], ret(1))])
+        out, records = inline_program(Program([Module("m", [fact, main])]), "O2")
+        self.assertEqual(records, [])
+        self.assertEqual(run(out, "main", []), 120)
+
+    def test_o2_specialises_large_callees_on_constant_arguments(self) -> None:
+        main = function("main", [i64("x", 0)], [
+            Block(BlockId(0), "entry", [ci(1, "3"), call(2, "poly", 0, 1), call(3, "poly", 2, 1)], ret(3)),
+        ])
+        prog = Program([Module("m", [poly(), main])])
+        self.assertGreater(inline_cost(poly()), POLICIES["O2"][0] + CONST_ARG_BONUS)
+        out, records = inline_program(prog, "O2")
+        self.assertEqual(records, [("main", "poly", "poly.spec.1_3"), ("main", "poly", "poly.spec.1_3")])
+        funcs = out.modules[0].functions
+        self.assertEqual([f.name for f in funcs], ["poly", "main", "poly.spec.1_3"])
+        spec = funcs[2]
+        check_ssa(spec)
+        self.assertEqual([p.name for p in spec.params], ["x"])
+        self.assertEqual([i.args for b in funcs[1].blocks for i in b.instrs if i.tag is InstrTag.CALL],
+                         [[ValueId(0)], [ValueId(2)]])
+        self.assertEqual(run(out, "main", [2]), run(prog, "main", [2]))
+        self.assertEqual(count_calls(out), count_calls(prog))
+
+
+if __name__ == "__main__":
+    unittest.main()
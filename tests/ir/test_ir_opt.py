@@ -0,0 +1,663 @@
+from __future__ import annotations
+
+from dataclasses import replace
+from typing import Dict, List, Optional, Set, Tuple
+import unittest
+
+from tests.ir.test_ir_dump import (
+    BinOp,
+    Block,
+    BlockId,
+    Function,
+    Instr,
+    InstrTag,
+    Module,
+    Param,
+    Program,
+    Terminator,
+    Type,
+    TypeKind,
+    UnOp,
+    ValueId,
+    format_program,
+)
+
+
+# Python mirror of compiler/ir/ir_opt.vitte (same passes, same order).
+
+PIPELINES = {
+    "O0": [],
+    "O1": ["const_fold", "simplify_cfg", "dce"],
+    "O2": ["const_fold", "gvn", "licm", "const_fold", "simplify_cfg", "dce"],
+}
+MAX_ROUNDS = 4
+Const = Tuple[bool, object]  # (is_bool, value)
+
+
+def successors(b: Block) -> List[BlockId]:
+    t = b.terminator
+    if t is None or t.kind == "return":
+        return []
+    if t.kind == "jump":
+        return [t.target]
+    return [t.then_tgt, t.else_tgt]
+
+
+def operands(inst: Instr) -> List[ValueId]:
+    if inst.tag is InstrTag.BINOP:
+        return [inst.lhs, inst.rhs]
+    if inst.tag is InstrTag.UNOP:
+        return [inst.operand]
+    if inst.tag is InstrTag.CALL:
+        return list(inst.args or [])
+    if inst.tag is InstrTag.MAKE_TUPLE:
+        return list(inst.items or [])
+    if inst.tag is InstrTag.PHI:
+        return [v for _, v in inst.incomings or []]
+    return []
+
+
+def term_operands(b: Block) -> List[ValueId]:
+    t = b.terminator
+    if t is not None and t.kind in ("return", "cond_jump") and t.value is not None:
+        return [t.value]
+    return []
+
+
+def resolve(alias: Dict[int, ValueId], v: ValueId) -> ValueId:
+    while v.raw in alias:
+        v = alias[v.raw]
+    return v
+
+
+def rewrite_instr(inst: Instr, alias: Dict[int, ValueId]) -> Instr:
+    r = lambda v: resolve(alias, v)
+    if inst.tag is InstrTag.BINOP:
+        return replace(inst, lhs=r(inst.lhs), rhs=r(inst.rhs))
+    if inst.tag is InstrTag.UNOP:
+        return replace(inst, operand=r(inst.operand))
+    if inst.tag is InstrTag.CALL:
+        return replace(inst, args=[r(v) for v in inst.args or []])
+    if inst.tag is InstrTag.MAKE_TUPLE:
+        return replace(inst, items=[r(v) for v in inst.items or []])
+    if inst.tag is InstrTag.PHI:
+        return replace(inst, incomings=[(b, r(v)) for b, v in inst.incomings or []])
+    return inst
+
+
+def rewrite_term(t: Optional[Terminator], alias: Dict[int, ValueId]) -> Optional[Terminator]:
+    if t is not None and t.value is not None:
+        return replace(t, value=resolve(alias, t.value))
+    return t
+
+
+def rewrite_function(f: Function, alias: Dict[int, ValueId]) -> Function:
+    blocks = [
+        replace(b, instrs=[rewrite_instr(i, alias) for i in b.instrs if i.result.raw not in alias],
+                terminator=rewrite_term(b.terminator, alias))
+        for b in f.blocks
+    ]
+    return replace(f, blocks=blocks)
+
+
+def block_index(f: Function) -> Dict[int, int]:
+    return {b.id.raw: i for i, b in enumerate(f.blocks)}
+
+
+def predecessors(f: Function) -> Dict[int, List[BlockId]]:
+    preds: Dict[int, List[BlockId]] = {b.id.raw: [] for b in f.blocks}
+    for b in f.blocks:
+        succ = successors(b)
+        for k, s in enumerate(succ):
+            if s.raw in preds and (k == 0 or succ[0].raw != s.raw):
+                preds[s.raw].append(b.id)
+    return preds
+
+
+def reverse_postorder(f: Function) -> List[int]:
+    index = block_index(f)
+    visited = {f.entry.raw}
+    post: List[int] = []
+    stack = [(index[f.entry.raw], 0)]
+    while stack:
+        bi, k = stack[-1]
+        succ = successors(f.blocks[bi])
+        if k < len(succ):
+            stack[-1] = (bi, k + 1)
+            s = succ[k]
+            if s.raw in index and s.raw not in visited:
+                visited.add(s.raw)
+                stack.append((index[s.raw], 0))
+        else:
+            post.append(bi)
+            stack.pop()
+    return post[::-1]
+
+
+def immediate_dominators(f: Function, rpo: List[int], preds: Dict[int, List[BlockId]]) -> Dict[int, int]:
+    order = {f.blocks[i].id.raw: n for n, i in enumerate(rpo)}
+    idom = {f.entry.raw: f.entry.raw}
+    changed = True
+    while changed:
+        changed = False
+        for i in rpo[1:]:
+            b = f.blocks[i].id.raw
+            new: Optional[int] = None
+            for p in preds[b]:
+                if p.raw not in idom:
+                    continue
+                if new is None:
+                    new = p.raw
+                    continue
+                x, y = p.raw, new
+                while x != y:
+                    while order[x] > order[y]:
+                        x = idom[x]
+                    while order[y] > order[x]:
+                        y = idom[y]
+                new = x
+            if new is not None and idom.get(b) != new:
+                idom[b] = new
+                changed = True
+    return idom
+
+
+def dominates(idom: Dict[int, int], a: int, b: int) -> bool:
+    while True:
+        if b == a:
+            return True
+        if b not in idom or idom[b] == b:
+            return False
+        b = idom[b]
+
+
+def collect_consts(f: Function) -> Dict[int, Const]:
+    consts: Dict[int, Const] = {}
+    for b in f.blocks:
+        for inst in b.instrs:
+            if inst.tag is InstrTag.CONST_INT and inst.ty.kind is TypeKind.I64:
+                consts[inst.result.raw] = (False, int(inst.value))
+            if inst.tag is InstrTag.CONST_BOOL:
+                consts[inst.result.raw] = (True, inst.bool_value)
+    return consts
+
+
+def is_safe_div(rhs: ValueId, consts: Dict[int, Const]) -> bool:
+    c = consts.get(rhs.raw)
+    return c is not None and not c[0] and c[1] not in (0, -1)
+
+
+def is_pure(inst: Instr, consts: Dict[int, Const]) -> bool:
+    if inst.tag in (InstrTag.CONST_INT, InstrTag.CONST_BOOL, InstrTag.CONST_STRING, InstrTag.PHI,
+                    InstrTag.UNOP, InstrTag.MAKE_TUPLE):
+        return True
+    if inst.tag is InstrTag.BINOP:
+        return inst.binop is not BinOp.DIV or is_safe_div(inst.rhs, consts)
+    return False
+
+
+def make_const(inst: Instr, c: Const) -> Instr:
+    if c[0]:
+        return replace(inst, tag=InstrTag.CONST_BOOL, bool_value=c[1], binop=None, lhs=None, rhs=None,
+                       unop=None, operand=None, incomings=None)
+    return replace(inst, tag=InstrTag.CONST_INT, value=str(c[1]), binop=None, lhs=None, rhs=None,
+                   unop=None, operand=None, incomings=None)
+
+
+def fold_binop(op: BinOp, a: Const, b: Const) -> Optional[Const]:
+    if a[0] or b[0]:
+        if a[0] and b[0] and op in (BinOp.EQ, BinOp.NE):
+            return (True, (a[1] == b[1]) == (op is BinOp.EQ))
+        return None
+    x, y = a[1], b[1]
+    if op is BinOp.DIV:
+        if y in (0, -1):
+            return None
+        q = abs(x) // abs(y)
+        return (False, q if (x < 0) == (y < 0) else -q)
+    arith = {BinOp.ADD: lambda: x + y, BinOp.SUB: lambda: x - y, BinOp.MUL: lambda: x * y}
+    if op in arith:
+        return (False, arith[op]())
+    cmp = {BinOp.EQ: x == y, BinOp.NE: x != y, BinOp.LT: x < y, BinOp.LE: x <= y, BinOp.GT: x > y, BinOp.GE: x >= y}
+    return (True, cmp[op])
+
+
+def fold_unop(op: UnOp, a: Const) -> Optional[Const]:
+    if op is UnOp.NEG:
+        return None if a[0] else (False, -a[1])
+    return (True, not a[1]) if a[0] else None
+
+
+def const_fold(f: Function) -> Tuple[Function, int]:
+    changes = 0
+    consts = collect_consts(f)
+    alias: Dict[int, ValueId] = {}
+    blocks = list(f.blocks)
+    progress = True
+    while progress:
+        progress = False
+        for bi, b in enumerate(blocks):
+            instrs = list(b.instrs)
+            for ii, inst in enumerate(instrs):
+                inst = rewrite_instr(inst, alias)
+                instrs[ii] = inst
+                if inst.result.raw in consts or inst.result.raw in alias:
+                    continue
+                folded: Optional[Const] = None
+                if inst.tag is InstrTag.BINOP and inst.lhs.raw in consts and inst.rhs.raw in consts:
+                    folded = fold_binop(inst.binop, consts[inst.lhs.raw], consts[inst.rhs.raw])
+                elif inst.tag is InstrTag.UNOP and inst.operand.raw in consts:
+                    folded = fold_unop(inst.unop, consts[inst.operand.raw])
+                elif inst.tag is InstrTag.PHI:
+                    same: Optional[ValueId] = None
+                    uniform = bool(inst.incomings)
+                    for _, v in inst.incomings:
+                        if v.raw == inst.result.raw:
+                            continue
+                        if same is None:
+                            same = v
+                        elif same.raw != v.raw and not (same.raw in consts and v.raw in consts and consts[same.raw] == consts[v.raw]):
+                            uniform = False
+                    if uniform and same is not None:
+                        if same.raw in consts:
+                            folded = consts[same.raw]
+                        else:
+                            alias[inst.result.raw] = same
+                            changes += 1
+                            progress = True
+                if folded is not None:
+                    instrs[ii] = make_const(inst, folded)
+                    consts[inst.result.raw] = folded
+                    changes += 1
+                    progress = True
+            term = rewrite_term(b.terminator, alias)
+            if term is not None and term.kind == "cond_jump" and term.value.raw in consts and consts[term.value.raw][0]:
+                term = Terminator(kind="jump", target=term.then_tgt if consts[term.value.raw][1] else term.else_tgt)
+                changes += 1
+            blocks[bi] = replace(b, instrs=instrs, terminator=term)
+    return rewrite_function(replace(f, blocks=blocks), alias), changes
+
+
+def dce(f: Function) -> Tuple[Function, int]:
+    consts = collect_consts(f)
+    defs: Dict[int, Instr] = {}
+    work: List[ValueId] = []
+    for b in f.blocks:
+        for inst in b.instrs:
+            defs[inst.result.raw] = inst
+            if inst.tag is InstrTag.PARAM or not is_pure(inst, consts):
+                work.append(inst.result)
+        work.extend(term_operands(b))
+    live: Set[int] = set()
+    while work:
+        v = work.pop()
+        if v.raw in live:
+            continue
+        live.add(v.raw)
+        if v.raw in defs:
+            work.extend(operands(defs[v.raw]))
+    changes = sum(1 for b in f.blocks for i in b.instrs if i.result.raw not in live)
+    blocks = [replace(b, instrs=[i for i in b.instrs if i.result.raw in live]) for b in f.blocks]
+    return replace(f, blocks=blocks), changes
+
+
+def retarget(t: Terminator, src: BlockId, dst: BlockId) -> Terminator:
+    swap = lambda b: dst if b is not None and b.raw == src.raw else b
+    return replace(t, target=swap(t.target), then_tgt=swap(t.then_tgt), else_tgt=swap(t.else_tgt))
+
+
+def has_phi(b: Block) -> bool:
+    return any(i.tag is InstrTag.PHI for i in b.instrs)
+
+
+def rename_phi_source(b: Block, src: BlockId, dst: BlockId) -> Block:
+    instrs = [
+        replace(i, incomings=[(dst if p.raw == src.raw else p, v) for p, v in i.incomings]) if i.tag is InstrTag.PHI else i
+        for i in b.instrs
+    ]
+    return replace(b, instrs=instrs)
+
+
+def prune_cfg(f: Function) -> Tuple[Function, int]:
+    reachable = {f.blocks[i].id.raw for i in reverse_postorder(f)}
+    kept = [b for b in f.blocks if b.id.raw in reachable]
+    changes = len(f.blocks) - len(kept)
+    g = replace(f, blocks=kept)
+    preds = predecessors(g)
+    alias: Dict[int, ValueId] = {}
+    blocks = []
+    for b in g.blocks:
+        pred_ids = {p.raw for p in preds[b.id.raw]}
+        instrs = []
+        for inst in b.instrs:
+            if inst.tag is InstrTag.PHI:
+                out = [(p, v) for p, v in inst.incomings if p.raw in pred_ids]
+                changes += len(inst.incomings) - len(out)
+                if len(out) == 1 and out[0][1].raw != inst.result.raw:
+                    alias[inst.result.raw] = out[0][1]
+                    changes += 1
+                inst = replace(inst, incomings=out)
+            instrs.append(inst)
+        blocks.append(replace(b, instrs=instrs))
+    return rewrite_function(replace(g, blocks=blocks), alias), changes
+
+
+def simplify_cfg(f: Function) -> Tuple[Function, int]:
+    changes = 0
+    cur = f
+    progress = True
+    while progress:
+        progress = False
+        cur, pruned = prune_cfg(cur)
+        changes += pruned
+        blocks = list(cur.blocks)
+        for i, b in enumerate(blocks):
+            t = b.terminator
+            if t is not None and t.kind == "cond_jump" and t.then_tgt.raw == t.else_tgt.raw:
+                blocks[i] = replace(b, terminator=Terminator(kind="jump", target=t.then_tgt))
+                changes += 1
+        cur = replace(cur, blocks=blocks)
+        preds = predecessors(cur)
+        index = block_index(cur)
+        for i, a in enumerate(cur.blocks):
+            if progress:
+                break
+            if a.terminator is None or a.terminator.kind != "jump":
+                continue
+            t = a.terminator.target
+            bidx = index[t.raw]
+            b = cur.blocks[bidx]
+            if t.raw != cur.entry.raw and t.raw != a.id.raw and len(preds[t.raw]) == 1 and not has_phi(b):
+                succ = {s.raw for s in successors(b)}
+                merged = []
+                for j, blk in enumerate(cur.blocks):
+                    if j == i:
+                        merged.append(rename_phi_source(replace(a, instrs=a.instrs + b.instrs, terminator=b.terminator), b.id, a.id))
+                    elif j != bidx:
+                        merged.append(rename_phi_source(blk, b.id, a.id) if blk.id.raw in succ else blk)
+                cur = replace(cur, blocks=merged)
+                changes += 1
+                progress = True
+            elif t.raw != cur.entry.raw and not b.instrs and not has_phi(b) and a.id.raw != t.raw:
+                if b.terminator is not None and b.terminator.kind == "jump":
+                    c = b.terminator.target
+                    if c.raw != t.raw and not has_phi(cur.blocks[index[c.raw]]):
+                        redirected = list(cur.blocks)
+                        redirected[i] = replace(a, terminator=retarget(a.terminator, t, c))
+                        cur = replace(cur, blocks=redirected)
+                        changes += 1
+                        progress = True
+    return cur, changes
+
+
+COMMUTATIVE = (BinOp.ADD, BinOp.MUL, BinOp.EQ, BinOp.NE)
+
+
+def value_key(inst: Instr) -> Optional[tuple]:
+    ty = inst.ty.kind
+    if inst.tag is InstrTag.CONST_INT:
+        return ("ci", inst.value, ty)
+    if inst.tag is InstrTag.CONST_BOOL:
+        return ("cb", inst.bool_value, ty)
+    if inst.tag is InstrTag.CONST_STRING:
+        return ("cs", inst.value, ty)
+    if inst.tag is InstrTag.UNOP:
+        return (inst.unop, inst.operand.raw, ty)
+    if inst.tag is InstrTag.BINOP:
+        a, b = inst.lhs.raw, inst.rhs.raw
+        if inst.binop in COMMUTATIVE and b < a:
+            a, b = b, a
+        return (inst.binop, a, b, ty)
+    if inst.tag is InstrTag.MAKE_TUPLE:
+        return ("tuple", tuple(v.raw for v in inst.items), ty)
+    return None
+
+
+def gvn(f: Function) -> Tuple[Function, int]:
+    rpo = reverse_postorder(f)
+    idom = immediate_dominators(f, rpo, predecessors(f))
+    consts = collect_consts(f)
+    alias: Dict[int, ValueId] = {}
+    table: Dict[tuple, List[Tuple[ValueId, int]]] = {}
+    changes = 0
+    for bi in rpo:
+        b = f.blocks[bi]
+        for inst in b.instrs:
+            inst = rewrite_instr(inst, alias)
+            key = value_key(inst) if is_pure(inst, consts) else None
+            if key is None:
+                continue
+            hit = next((v for v, blk in table.get(key, []) if dominates(idom, blk, b.id.raw)), None)
+            if hit is not None:
+                alias[inst.result.raw] = hit
+                changes += 1
+            else:
+                table.setdefault(key, []).append((inst.result, b.id.raw))
+    return rewrite_function(f, alias), changes
+
+
+def licm_one_loop(f: Function) -> Tuple[Function, int]:
+    rpo = reverse_postorder(f)
+    preds = predecessors(f)
+    idom = immediate_dominators(f, rpo, preds)
+    consts = collect_consts(f)
+    index = block_index(f)
+    for r in rpo:
+        head = f.blocks[r]
+        latches = [p.raw for p in preds[head.id.raw] if p.raw in idom and dominates(idom, head.id.raw, p.raw)]
+        outside = [p for p in preds[head.id.raw] if p.raw not in latches]
+        if not latches or len(outside) != 1:
+            continue
+        body = {head.id.raw}
+        work = list(latches)
+        while work:
+            b = work.pop()
+            if b in body:
+                continue
+            body.add(b)
+            work.extend(p.raw for p in preds[b])
+        def_block = {i.result.raw: b.id.raw for b in f.blocks for i in b.instrs}
+        hoisted: List[Instr] = []
+        moved: Set[int] = set()
+        progress = True
+        while progress:
+            progress = False
+            for k in rpo:
+                b = f.blocks[k]
+                if b.id.raw not in body:
+                    continue
+                for inst in b.instrs:
+                    if inst.result.raw in moved or inst.tag is InstrTag.PHI or not is_pure(inst, consts):
+                        continue
+                    if all(not (v.raw in def_block and def_block[v.raw] in body and v.raw not in moved) for v in operands(inst)):
+                        hoisted.append(inst)
+                        moved.add(inst.result.raw)
+                        progress = True
+        if not hoisted:
+            continue
+        blocks = [replace(b, instrs=[i for i in b.instrs if i.result.raw not in moved]) for b in f.blocks]
+        pred = outside[0]
+        pidx = index[pred.raw]
+        if blocks[pidx].terminator.kind == "jump":
+            blocks[pidx] = replace(blocks[pidx], instrs=blocks[pidx].instrs + hoisted)
+        else:
+            pre_id = BlockId(max(b.id.raw for b in f.blocks) + 1)
+            blocks[pidx] = replace(blocks[pidx], terminator=retarget(blocks[pidx].terminator, head.id, pre_id))
+            hidx = index[head.id.raw]
+            blocks[hidx] = rename_phi_source(blocks[hidx], pred, pre_id)
+            blocks.append(Block(pre_id, head.name + ".preheader", hoisted, Terminator(kind="jump", target=head.id)))
+        return replace(f, blocks=blocks), len(hoisted)
+    return f, 0
+
+
+def licm(f: Function) -> Tuple[Function, int]:
+    changes = 0
+    budget = len(f.blocks)
+    step = licm_one_loop(f)
+    while step[1] > 0 and budget > 0:
+        f = step[0]
+        changes += step[1]
+        step = licm_one_loop(f)
+        budget -= 1
+    return f, changes
+
+
+PASSES = {"const_fold": const_fold, "gvn": gvn, "licm": licm, "simplify_cfg": simplify_cfg, "dce": dce}
+
+
+def optimize_module(m: Module, level: str) -> Tuple[Module, List[Tuple[str, str, int]]]:
+    records: List[Tuple[str, str, int]] = []
+    rounds = MAX_ROUNDS if level == "O2" else 1
+    funcs = []
+    for f in m.functions:
+        for _ in range(rounds):
+            total = 0
+            for name in PIPELINES[level]:
+                f, changes = PASSES[name](f)
+                records.append((name, f.name, changes))
+                total += changes
+            if total == 0:
+                break
+        funcs.append(f)
+    return Module(m.name, funcs), records
+
+
+def check_ssa(f: Function) -> None:
+    # Every use is defined once, phi sources are predecessors, every block reachable.
+    defined = {p.value.raw for p in f.params}
+    for b in f.blocks:
+        for i in b.instrs:
+            assert i.result.raw not in defined, f"redefined %{i.result.raw}"
+            defined.add(i.result.raw)
+    preds = predecessors(f)
+    for b in f.blocks:
+        for i in b.instrs:
+            for v in operands(i):
+                assert v.raw in defined, f"use of undefined %{v.raw}"
+            if i.tag is InstrTag.PHI:
+                assert {p.raw for p, _ in i.incomings} <= {p.raw for p in preds[b.id.raw]}
+        for v in term_operands(b):
+            assert v.raw in defined, f"use of undefined %{v.raw}"
+    assert len(reverse_postorder(f)) == len(f.blocks)
+
+
+def ci(v: int, text: str) -> Instr:
+    return Instr(tag=InstrTag.CONST_INT, result=ValueId(v), ty=Type.i64(), value=text)
+
+
+def bin_(v: int, op: BinOp, lhs: int, rhs: int, ty: Optional[Type] = None) -> Instr:
+    result_ty = ty or (Type.bool() if op in (BinOp.EQ, BinOp.NE, BinOp.LT, BinOp.LE, BinOp.GT, BinOp.GE) else Type.i64())
+    return Instr(tag=InstrTag.BINOP, result=ValueId(v), ty=result_ty, binop=op, lhs=ValueId(lhs), rhs=ValueId(rhs))
+
+
+def phi(v: int, *incs: Tuple[int, int]) -> Instr:
+    return Instr(tag=InstrTag.PHI, result=ValueId(v), ty=Type.i64(), incomings=[(BlockId(b), ValueId(x)) for b, x in incs])
+
+
+def ret(v: int) -> Terminator:
+    return Terminator(kind="return", value=ValueId(v))
+
+
+def jump(b: int) -> Terminator:
+    return Terminator(kind="jump", target=BlockId(b))
+
+
+def br(c: int, t: int, e: int) -> Terminator:
+    return Terminator(kind="cond_jump", value=ValueId(c), then_tgt=BlockId(t), else_tgt=BlockId(e))
+
+
+def function(name: str, params: List[Param], blocks: List[Block]) -> Function:
+    return Function(name=name, params=params, ret_type=Type.i64(), blocks=blocks, entry=BlockId(0))
+
+
+def folded_branch() -> Function:
+    # a = 2 + 3 ; b = a * 4 ; if b > 10 { ret b } else { ret 0 }
+    return function("fold", [], [
+        Block(BlockId(0), "entry", [ci(0, "2"), ci(1, "3"), bin_(2, BinOp.ADD, 0, 1), ci(3, "4"),
+                                    bin_(4, BinOp.MUL, 2, 3), ci(5, "10"), bin_(6, BinOp.GT, 4, 5)], br(6, 1, 2)),
+        Block(BlockId(1), "then", [], ret(4)),
+        Block(BlockId(2), "else", [ci(7, "0")], ret(7)),
+    ])
+
+
+def sum_loop() -> Function:
+    # s = 0 ; i = 0 ; while i < n { s = s + k * 2 ; i = i + 1 } ; ret s + (k * 2)
+    params = [Param("n", Type.i64(), ValueId(0)), Param("k", Type.i64(), ValueId(1))]
+    return function("sum", params, [
+        Block(BlockId(0), "entry", [ci(2, "0")], jump(1)),
+        Block(BlockId(1), "head", [phi(3, (0, 2), (2, 8)), phi(4, (0, 2), (2, 10)), bin_(5, BinOp.LT, 4, 0)], br(5, 2, 3)),
+        Block(BlockId(2), "body", [ci(6, "2"), bin_(7, BinOp.MUL, 1, 6), bin_(8, BinOp.ADD, 3, 7), ci(9, "1"),
+                                   bin_(10, BinOp.ADD, 4, 9)], jump(1)),
+        Block(BlockId(3), "exit", [ci(11, "2"), bin_(12, BinOp.MUL, 6, 1), bin_(13, BinOp.ADD, 3, 12)], ret(13)),
+    ])
+
+
+class IrOptTest(unittest.TestCase):
+    def test_o0_leaves_the_module_untouched(self) -> None:
+        m = Module("m", [folded_branch()])
+        out, records = optimize_module(m, "O0")
+        self.assertEqual(out, m)
+        self.assertEqual(records, [])
+
+    def test_o1_folds_constants_and_removes_the_dead_branch(self) -> None:
+        out, records = optimize_module(Module("m", [folded_branch()]), "O1")
+        f = out.functions[0]
+        check_ssa(f)
+        self.assertEqual(format_program(Program([out])), (
+            "module m\n"
+            "\n"
+            "fn fold() -> i64\n"
+            "  block bb0 (entry):\n"
+            "    %4 = const 20 : i64\n"
+            "    ret %4\n"
+        ))
+        self.assertEqual([r[0] for r in records], PIPELINES["O1"])
+        self.assertTrue(all(r[2] > 0 for r in records))
+
+    def test_o2_hoists_invariants_and_numbers_redundant_values(self) -> None:
+        out, _ = optimize_module(Module("m", [sum_loop()]), "O2")
+        f = out.functions[0]
+        check_ssa(f)
+        by_name = {b.name: b for b in f.blocks}
+        # k * 2 is computed once, before the loop, and reused after it.
+        muls = [(b.name, i) for b in f.blocks for i in b.instrs if i.tag is InstrTag.BINOP and i.binop is BinOp.MUL]
+        self.assertEqual(len(muls), 1)
+        self.assertEqual(muls[0][0], "entry")
+        self.assertNotIn(InstrTag.CONST_INT, [i.tag for i in by_name["body"].instrs if i.value == "2"])
+        exit_add = by_name["exit"].instrs[-1]
+        self.assertEqual(exit_add.rhs, muls[0][1].result)
+        # The loop-carried phis and the exit test survive.
+        self.assertEqual([i.tag for i in by_name["head"].instrs], [InstrTag.PHI, InstrTag.PHI, InstrTag.BINOP])
+
+    def test_licm_creates_a_preheader_for_a_conditional_entry(self) -> None:
+        # entry: br flag, head, out ; head: phi ; body: x = k + k ; ...
+        params = [Param("flag", Type.bool(), ValueId(0)), Param("k", Type.i64(), ValueId(1))]
+        f = function("guarded", params, [
+            Block(BlockId(0), "entry", [ci(2, "0")], br(0, 1, 3)),
+            Block(BlockId(1), "head", [phi(3, (0, 2), (2, 5)), bin_(4, BinOp.ADD, 1, 1), bin_(5, BinOp.ADD, 3, 4),
+                                       bin_(6, BinOp.LT, 5, 1)], br(6, 2, 3)),
+            Block(BlockId(2), "latch", [], jump(1)),
+            Block(BlockId(3), "out", [], ret(2)),
+        ])
+        g, changes = licm(f)
+        check_ssa(g)
+        self.assertEqual(changes, 1)
+        pre = g.blocks[-1]
+        self.assertEqual(pre.name, "head.preheader")
+        self.assertEqual([i.result.raw for i in pre.instrs], [4])
+        self.assertEqual(g.blocks[0].terminator.then_tgt, pre.id)
+        self.assertEqual(g.blocks[1].instrs[0].incomings[0][0], pre.id)
+
+    def test_division_that_may_trap_is_neither_folded_nor_removed(self) -> None:
+        params = [Param("d", Type.i64(), ValueId(0))]
+        f = function("div", params, [
+            Block(BlockId(0), "entry", [ci(1, "7"), ci(2, "0"), bin_(3, BinOp.DIV, 1, 2), bin_(4, BinOp.DIV, 1, 0),
+                                        ci(5, "2"), bin_(6, BinOp.DIV, 1, 5)], ret(1)),
+        ])
+        out, _ = optimize_module(Module("m", [f]), "O2")
+        kept = [i.result.raw for i in out.functions[0].blocks[0].instrs]
+        self.assertEqual(kept, [1, 2, 3, 4])
+
+
+if __name__ == "__main__":
+    unittest.main()
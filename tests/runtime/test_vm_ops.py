@@ -2,7 +2,14 @@ from __future__ import annotations
 
 from dataclasses import dataclass, field
 from enum import IntEnum, Enum, auto
-from typing import List
+from typing import Callable, List
+import ctypes
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+import time
 import unittest
 
 
@@ -44,6 +51,30 @@ class Opcode(IntEnum):
     OP_STD_CONCAT_STRING = 26
     OP_STD_ARRAY_PUSH = 27
     OP_STD_ARRAY_GET = 28
+    OP_R_MOV = 29
+    OP_R_CONST = 30
+    OP_R_ADD = 31
+    OP_R_SUB = 32
+    OP_R_MUL = 33
+    OP_R_DIV = 34
+    OP_R_CMP_EQ = 35
+    OP_R_CMP_NE = 36
+    OP_R_CMP_LT = 37
+    OP_R_CMP_LE = 38
+    OP_R_CMP_GT = 39
+    OP_R_CMP_GE = 40
+    OP_R_NEG = 41
+    OP_R_NOT = 42
+    OP_R_JMP_IF = 43
+    OP_R_CALL = 44
+    OP_R_RET = 45
+    OP_INC_LOCAL = 46
+    OP_LOAD_LOCAL2 = 47
+    OP_CMP_LT_JMP = 48
+
+
+FFLAG_REGISTER = 0x0004
+FFLAG_NOJIT = 0x0008
 
 
 class VmValueTag(Enum):
@@ -60,6 +91,7 @@ class HeapTag(Enum):
     STRING = auto()
     ARRAY = auto()
     STRUCT = auto()
+    I64 = auto()
 
 
 @dataclass
@@ -89,14 +121,82 @@ class FunctionEntry:
 class VmFrame:
     func_index: int
     pc: int
-    locals: List[VmValue]
+    locals_base: int
     stack_base: int
+    ret_reg: int = -1
 
 
 @dataclass
 class HeapObject:
     tag: HeapTag
     payload: object
+    shape: int = -1
+
+
+@dataclass
+class VmInst:
+    opcode: Opcode
+    operand: int
+    operand_b: int
+    operand_c: int
+    target: int
+    byte_pc: int
+    op_byte: int = -1  # opcode byte without the wide prefix
+
+
+IC_WAYS = 4
+
+# Baseline tier (mirror of vitte.runtime.jit): scalar register functions to C.
+JIT_DEOPT = -1
+JIT_T_INT, JIT_T_BOOL, JIT_T_NIL = 0, 1, 2
+JIT_SCALAR_OPS = {
+    Opcode.OP_R_MOV, Opcode.OP_R_CONST, Opcode.OP_R_ADD, Opcode.OP_R_SUB, Opcode.OP_R_MUL, Opcode.OP_R_DIV,
+    Opcode.OP_R_CMP_EQ, Opcode.OP_R_CMP_NE, Opcode.OP_R_CMP_LT, Opcode.OP_R_CMP_LE, Opcode.OP_R_CMP_GT,
+    Opcode.OP_R_CMP_GE, Opcode.OP_R_NEG, Opcode.OP_R_NOT, Opcode.OP_R_JMP_IF, Opcode.OP_JMP,
+    Opcode.OP_R_CALL, Opcode.OP_R_RET,
+}
+
+
+@dataclass
+class JitTier:
+    compile_c: object  # (source, symbol) -> callable | None
+    threshold: int = 1000
+    counters: dict = field(default_factory=dict)
+    native: dict = field(default_factory=dict)  # func_index -> callable, None = failed
+    native_calls: int = 0
+    deopts: int = 0
+
+    def tick(self, f: int) -> bool:
+        if f in self.native:
+            return False
+        self.counters[f] = self.counters.get(f, 0) + 1
+        return self.counters[f] >= self.threshold
+
+
+@dataclass
+class InlineCache:
+    # Mirror of vitte.runtime.icache: mono -> poly (IC_WAYS keys) -> mega.
+    keys: List[int] = field(default_factory=list)
+    values: List[int] = field(default_factory=list)
+    mega: bool = False
+    hits: int = 0
+    misses: int = 0
+
+    def lookup(self, key: int) -> int:
+        if key in self.keys:
+            self.hits += 1
+            return self.values[self.keys.index(key)]
+        self.misses += 1
+        return -1
+
+    def update(self, key: int, value: int) -> None:
+        if self.mega:
+            return
+        if len(self.keys) >= IC_WAYS:
+            self.mega, self.keys, self.values = True, [], []
+            return
+        self.keys.append(key)
+        self.values.append(value)
 
 
 @dataclass
@@ -104,10 +204,21 @@ class VmState:
     const_pool: List[Const]
     functions: List[FunctionEntry]
     code: List[int]
+    code_base: int = 0
+    compact: bool = False  # header version_minor == 2
+    insts: List[VmInst] = field(default_factory=list)
+    func_entry: List[int] = field(default_factory=list)
+    caches: List[InlineCache] = field(default_factory=list)
     frames: List[VmFrame] = field(default_factory=list)
+    frame_depth: int = 0
     stack: List[VmValue] = field(default_factory=list)
     heap: List[HeapObject] = field(default_factory=list)
+    const_strings: List[int] = field(default_factory=list)
+    interned_count: int = 0
     printed: List[str] = field(default_factory=list)
+    tier: JitTier | None = None
+    ngrams: NgramProfile | None = None
+    profile: VmProfile | None = None
 
 
 @dataclass
@@ -184,6 +295,14 @@ def validate_code_bytes(code: List[int]) -> str:
             expected = 0
         if opcode == Opcode.OP_STD_MAKE_STRING:
             expected = 1
+        if opcode in (Opcode.OP_R_MOV, Opcode.OP_R_CONST, Opcode.OP_R_NEG, Opcode.OP_R_NOT, Opcode.OP_R_JMP_IF):
+            expected = 2
+        if Opcode.OP_R_ADD <= opcode <= Opcode.OP_R_CMP_GE or opcode == Opcode.OP_R_CALL:
+            expected = 3
+        if opcode in (Opcode.OP_R_RET, Opcode.OP_CMP_LT_JMP):
+            expected = 1
+        if opcode in (Opcode.OP_INC_LOCAL, Opcode.OP_LOAD_LOCAL2):
+            expected = 2
         if expected == -1:
             return f"unknown opcode byte {opcode} at byte {pc}"
         if operand_count != expected:
@@ -197,6 +316,111 @@ def validate_code_bytes(code: List[int]) -> str:
     return ""
 
 
+# Compact encoding (bytecode 0.2, mirror of vitte.runtime.bytecode / vitte.compiler.compact).
+LVM_MINOR_MVP, LVM_MINOR_COMPACT = 1, 2
+LVM_WIDE16, LVM_WIDE32, LVM_PAD = 0xFD, 0xFE, 0xFF
+LVM_JUMP_ALIGN = 4
+OPERAND_COUNT = {
+    **{op: 0 for op in Opcode},
+    **{op: 1 for op in (Opcode.OP_CONST, Opcode.OP_JMP, Opcode.OP_JMP_IF, Opcode.OP_LOAD_LOCAL, Opcode.OP_STORE_LOCAL,
+                        Opcode.OP_LOAD_FIELD, Opcode.OP_STORE_FIELD, Opcode.OP_ALLOC_HEAP, Opcode.OP_CALL,
+                        Opcode.OP_STD_MAKE_STRING, Opcode.OP_R_RET, Opcode.OP_CMP_LT_JMP)},
+    **{op: 2 for op in (Opcode.OP_R_MOV, Opcode.OP_R_CONST, Opcode.OP_R_NEG, Opcode.OP_R_NOT, Opcode.OP_R_JMP_IF,
+                        Opcode.OP_INC_LOCAL, Opcode.OP_LOAD_LOCAL2)},
+    **{op: 3 for op in Opcode if Opcode.OP_R_ADD <= op <= Opcode.OP_R_CMP_GE or op is Opcode.OP_R_CALL},
+}
+
+
+def offset_operand(opcode: int) -> int:
+    if opcode in (Opcode.OP_JMP, Opcode.OP_JMP_IF, Opcode.OP_CMP_LT_JMP):
+        return 0
+    return 1 if opcode == Opcode.OP_R_JMP_IF else -1
+
+
+def align_up(pc: int) -> int:
+    return (pc + LVM_JUMP_ALIGN - 1) // LVM_JUMP_ALIGN * LVM_JUMP_ALIGN
+
+
+def jump_dest(compact: bool, end_pc: int, rel: int) -> int:
+    return align_up(end_pc) + rel * LVM_JUMP_ALIGN if compact else end_pc + rel
+
+
+def decode_compact_at(code: List[int], start: int, limit: int, pc: int) -> tuple[Opcode, List[int], int]:
+    # `start` : index absolu ; `pc` : offset rapporté dans les erreurs.
+    width, at = {LVM_WIDE16: (2, start + 1), LVM_WIDE32: (4, start + 1)}.get(code[start], (1, start))
+    if at >= limit:
+        raise ValueError(f"truncated instruction header at byte {pc}")
+    if code[at] >= len(Opcode):
+        raise ValueError(f"unknown opcode byte {code[at]} at byte {pc}")
+    opcode = Opcode(code[at])
+    count = OPERAND_COUNT[opcode]
+    if at + 1 + count * width > limit:
+        raise ValueError(f"instruction at byte {pc} truncated")
+    operands = []
+    for k in range(count):
+        base = at + 1 + k * width
+        val = int.from_bytes(bytes(code[base:base + width]), "little", signed=k == offset_operand(opcode) or width == 4)
+        operands.append(val)
+    return opcode, operands, at + 1 + count * width - start
+
+
+def compact_function(code: List[int]) -> List[int]:
+    insts, pcs, index_of_pc = [], [], {}
+    pc = 0
+    while pc < len(code):
+        opcode, operands, size = decode_at_pc(code, pc)
+        index_of_pc[pc] = len(insts)
+        pcs.append(pc)
+        insts.append([opcode, operands, -1, 1])  # opcode, operands, target, width
+        pc += size
+    fits = lambda v, w, signed: w == 4 or (-(1 << (8 * w - 1)) <= v < (1 << (8 * w - 1)) if signed else 0 <= v < (1 << (8 * w)))
+    widen = lambda w: 2 if w == 1 else 4
+    size_of = lambda inst: (inst[3] > 1) + 1 + len(inst[1]) * inst[3]
+    labels = set()
+    for i, inst in enumerate(insts):
+        rel = offset_operand(inst[0])
+        if rel >= 0:
+            inst[2] = index_of_pc[pcs[i] + 2 + 4 * len(inst[1]) + inst[1][rel]]
+            labels.add(inst[2])
+        for k, val in enumerate(inst[1]):
+            while k != rel and not fits(val, inst[3], False):
+                inst[3] = widen(inst[3])
+    changed = True
+    while changed:
+        changed, starts, at = False, [], 0
+        for i, inst in enumerate(insts):
+            at = align_up(at) if i in labels else at
+            starts.append(at)
+            at += size_of(inst)
+        for i, inst in enumerate(insts):
+            if inst[2] >= 0 and not fits((starts[inst[2]] - align_up(starts[i] + size_of(inst))) // 4, inst[3], True):
+                inst[3] = widen(inst[3])
+                changed = True
+    out: List[int] = []
+    for i, (opcode, operands, target, width) in enumerate(insts):
+        out += [LVM_PAD] * (starts[i] - len(out))
+        operands = list(operands)
+        rel = offset_operand(opcode)
+        if rel >= 0:
+            operands[rel] = (starts[target] - align_up(starts[i] + size_of(insts[i]))) // 4
+        out += {2: [LVM_WIDE16], 4: [LVM_WIDE32]}.get(width, []) + [int(opcode)]
+        for val in operands:
+            out += list((val & (2 ** (8 * width) - 1)).to_bytes(width, "little"))
+    return out
+
+
+def compact_chunk(functions: List[FunctionEntry], code: List[int]) -> tuple[List[FunctionEntry], List[int]]:
+    out: List[int] = []
+    entries = []
+    for func in functions:
+        body = compact_function(code[func.code_offset:func.code_offset + func.code_size])
+        out += [LVM_PAD] * (align_up(len(out)) - len(out))
+        entries.append(FunctionEntry(func.name_const, len(out), len(body), func.param_count, func.local_count,
+                                     func.max_stack, func.flags))
+        out += body
+    return entries, out
+
+
 def decode_at_pc(code: List[int], pc: int) -> tuple[Opcode, List[int], int]:
     opcode = Opcode(code[pc])
     operand_count = code[pc + 1]
@@ -204,11 +428,670 @@ def decode_at_pc(code: List[int], pc: int) -> tuple[Opcode, List[int], int]:
     for i in range(operand_count):
         base = pc + 2 + i * 4
         val = code[base] | (code[base + 1] << 8) | (code[base + 2] << 16) | (code[base + 3] << 24)
+        if val & 0x80000000:
+            val -= 1 << 32  # opérandes i32 signés (offsets de saut arrière)
         operands.append(val)
     size = 2 + operand_count * 4
     return opcode, operands, size
 
 
+def predecode_function(state: VmState, f: int) -> str:
+    func = state.functions[f]
+    start, size = func.code_offset, func.code_size
+    base = state.code_base + start
+    if size <= 0 or base + size > len(state.code):
+        return f"function {f} code out of bounds"
+    if not state.compact:
+        error = validate_code_bytes(state.code[base:base + size])
+        if error:
+            return error
+    first = len(state.insts)
+    sizes: List[int] = []
+    index_of_pc = [-1] * size
+    pc = 0
+    while pc < size:
+        if state.compact and state.code[base + pc] == LVM_PAD:
+            pc += 1
+            continue
+        if state.compact:
+            try:
+                opcode, operands, inst_size = decode_compact_at(state.code, base + pc, base + size, start + pc)
+            except ValueError as exc:
+                return str(exc)
+        else:
+            opcode, operands, inst_size = decode_at_pc(state.code, base + pc)
+        index_of_pc[pc] = len(state.insts)
+        padded = operands + [0] * (3 - len(operands))
+        state.insts.append(VmInst(opcode, padded[0], padded[1], padded[2], -1, start + pc, int(opcode)))
+        sizes.append(inst_size)
+        pc += inst_size
+    state.func_entry[f] = first
+    for k in range(first, len(state.insts)):
+        inst = state.insts[k]
+        if inst.opcode in (Opcode.OP_JMP, Opcode.OP_JMP_IF, Opcode.OP_CMP_LT_JMP, Opcode.OP_R_JMP_IF):
+            rel = inst.operand_b if inst.opcode is Opcode.OP_R_JMP_IF else inst.operand
+            dest = jump_dest(state.compact, inst.byte_pc - start + sizes[k - first], rel)
+            if not 0 <= dest < size or index_of_pc[dest] < 0:
+                return f"invalid jump target at byte {inst.byte_pc}"
+            inst.target = index_of_pc[dest]
+        if inst.opcode in (Opcode.OP_CALL, Opcode.OP_R_CALL):
+            callee = inst.operand if inst.opcode is Opcode.OP_CALL else inst.operand_b
+            if not 0 <= callee < len(state.func_entry):
+                return f"invalid call target at byte {inst.byte_pc}"
+            inst.target = state.func_entry[callee]
+        if inst.opcode in (Opcode.OP_LOAD_FIELD, Opcode.OP_STORE_FIELD, Opcode.OP_CALL_INDIRECT):
+            inst.target = len(state.caches)
+            state.caches.append(InlineCache())
+    return ""
+
+
+def predecode(state: VmState, lazy: bool = False) -> str:
+    state.insts = []
+    state.caches = []
+    state.func_entry = [-1] * len(state.functions)
+    if lazy:
+        return ""
+    for f in range(len(state.functions)):
+        error = predecode_function(state, f)
+        if error:
+            return error
+    for inst in state.insts:
+        if inst.opcode is Opcode.OP_CALL:
+            inst.target = state.func_entry[inst.operand]
+        if inst.opcode is Opcode.OP_R_CALL:
+            inst.target = state.func_entry[inst.operand_b]
+    return ""
+
+
+def ensure_function(state: VmState, f: int) -> None:
+    if state.func_entry[f] < 0:
+        error = predecode_function(state, f)
+        if error:
+            raise AssertionError(error)
+
+
+def resolve_call(state: VmState, at: int, fn_index: int) -> int:
+    inst = state.insts[at]
+    if inst.target < 0:
+        ensure_function(state, fn_index)
+        inst.target = state.func_entry[fn_index]
+    return inst.target
+
+
+def push_frame(state: VmState, fn_index: int, entry: int, locals_base: int, ret_reg: int = -1) -> None:
+    # Parameters already sit at locals_base; frame records are reused from the pool.
+    state.stack.extend(VmValue(VmValueTag.NIL, None) for _ in range(state.functions[fn_index].local_count))
+    frame = VmFrame(fn_index, entry, locals_base, len(state.stack), ret_reg)
+    if state.frame_depth < len(state.frames):
+        state.frames[state.frame_depth] = frame
+    else:
+        state.frames.append(frame)
+    state.frame_depth += 1
+    if state.profile is not None and state.profile.counting:
+        state.profile.func_calls[fn_index] = state.profile.func_calls.get(fn_index, 0) + 1
+
+
+def jit_decode_function(state: VmState, f: int) -> List[tuple[Opcode, List[int], int, int]]:
+    # (opcode, operandes, pc, cible du saut relative à la fonction ou -1) ;
+    # vide si le code est hors bornes, mal formé ou saute hors instruction.
+    func = state.functions[f]
+    base = state.code_base + func.code_offset
+    if func.code_size <= 0 or base + func.code_size > len(state.code):
+        return []
+    if not state.compact and validate_code_bytes(state.code[base:base + func.code_size]):
+        return []
+    out, pc = [], 0
+    while pc < func.code_size:
+        if state.compact and state.code[base + pc] == LVM_PAD:
+            pc += 1
+            continue
+        if state.compact:
+            try:
+                opcode, operands, size = decode_compact_at(state.code, base + pc, base + func.code_size, pc)
+            except ValueError:
+                return []
+        else:
+            opcode, operands, size = decode_at_pc(state.code, base + pc)
+        rel = offset_operand(opcode)
+        dest = jump_dest(state.compact, pc + size, operands[rel]) if rel >= 0 else -1
+        if rel >= 0 and dest < 0:
+            return []
+        out.append((opcode, operands + [0] * (3 - len(operands)), pc, dest))
+        pc += size
+    starts = {pc for _, _, pc, _ in out}
+    if any(dest >= 0 and dest not in starts for _, _, _, dest in out):
+        return []
+    return out
+
+
+def jit_operands_ok(state: VmState, slots: int, opcode: Opcode, ops: List[int]) -> bool:
+    # Mêmes règles que vm_check_register_function : le C émis indexe r[] sans contrôle.
+    reg = lambda r: 0 <= r < slots
+    a, b, c = ops
+    if opcode is Opcode.OP_JMP:
+        return True
+    if opcode is Opcode.OP_R_CONST:
+        return reg(a) and 0 <= b < len(state.const_pool)
+    if opcode in (Opcode.OP_R_JMP_IF, Opcode.OP_R_RET):
+        return reg(a)
+    if opcode is Opcode.OP_R_CALL:
+        return 0 <= b < len(state.functions) and reg(a) and c >= 0 and c + state.functions[b].param_count <= slots
+    if opcode in (Opcode.OP_R_MOV, Opcode.OP_R_NEG, Opcode.OP_R_NOT):
+        return reg(a) and reg(b)
+    return reg(a) and reg(b) and reg(c)
+
+
+def jit_collect(state: VmState, f: int) -> List[int]:
+    unit = [f]
+    for g in unit:
+        func = state.functions[g]
+        if not func.flags & FFLAG_REGISTER or func.flags & FFLAG_NOJIT:
+            return []
+        insts = jit_decode_function(state, g)
+        if not insts:
+            return []
+        for opcode, ops, _, _ in insts:
+            if opcode not in JIT_SCALAR_OPS or not jit_operands_ok(state, func.param_count + func.local_count, opcode, ops):
+                return []
+            if opcode is Opcode.OP_R_CONST and state.const_pool[ops[1]].tag not in (ConstTag.I64, ConstTag.BOOL, ConstTag.NIL):
+                return []
+            if opcode is Opcode.OP_R_CALL and ops[1] not in unit:
+                unit.append(ops[1])
+    return unit
+
+
+def jit_emit_inst(state: VmState, opcode: Opcode, ops: List[int], dest: int) -> str:
+    d, b, c = ops
+    R = lambda x: f"r[{x}]"
+    T = lambda x: f"t[{x}]"
+    I = lambda x: f"I({x})"
+    if opcode is Opcode.OP_R_MOV:
+        return f"{R(d)} = {R(b)}; {T(d)} = {T(b)};"
+    if opcode is Opcode.OP_R_CONST:
+        const = state.const_pool[b]
+        if const.tag is ConstTag.I64:
+            return f"{R(d)} = (int64_t){const.value & (2**64 - 1)}ULL; {T(d)} = 0;"
+        if const.tag is ConstTag.BOOL:
+            return f"{R(d)} = {1 if const.value else 0}; {T(d)} = 1;"
+        return f"{R(d)} = 0; {T(d)} = 2;"
+    if opcode in (Opcode.OP_R_ADD, Opcode.OP_R_SUB, Opcode.OP_R_MUL):
+        sym = {Opcode.OP_R_ADD: "+", Opcode.OP_R_SUB: "-", Opcode.OP_R_MUL: "*"}[opcode]
+        return f"{R(d)} = (int64_t)((uint64_t){I(b)} {sym} (uint64_t){I(c)}); {T(d)} = 0;"
+    if opcode is Opcode.OP_R_DIV:
+        return (f"{{ if ({I(c)} == 0 || ({I(b)} == INT64_MIN && {I(c)} == -1)) return -1; "
+                f"{R(d)} = {I(b)} / {I(c)}; {T(d)} = 0; }}")
+    if opcode in (Opcode.OP_R_CMP_EQ, Opcode.OP_R_CMP_NE):
+        eq = f"({T(b)} == {T(c)} && {T(b)} != 2 && {R(b)} == {R(c)})"
+        return f"{R(d)} = {eq if opcode is Opcode.OP_R_CMP_EQ else '!' + eq}; {T(d)} = 1;"
+    if Opcode.OP_R_CMP_LT <= opcode <= Opcode.OP_R_CMP_GE:
+        sym = {Opcode.OP_R_CMP_LT: "<", Opcode.OP_R_CMP_LE: "<=", Opcode.OP_R_CMP_GT: ">", Opcode.OP_R_CMP_GE: ">="}[opcode]
+        return f"{R(d)} = {I(b)} {sym} {I(c)}; {T(d)} = 1;"
+    if opcode is Opcode.OP_R_NEG:
+        return f"{R(d)} = (int64_t)(0 - (uint64_t){I(b)}); {T(d)} = 0;"
+    if opcode is Opcode.OP_R_NOT:
+        return f"{{ if ({T(b)} != 1) return -1; {R(d)} = !{R(b)}; {T(d)} = 1; }}"
+    if opcode is Opcode.OP_R_JMP_IF:
+        return f"{{ if ({T(d)} != 1) return -1; if ({R(d)}) goto L{dest}; }}"
+    if opcode is Opcode.OP_JMP:
+        return f"goto L{dest};"
+    if opcode is Opcode.OP_R_CALL:
+        return (f"{{ int64_t rv; int32_t k = vitte_jit_f{b}(&{R(c)}, &{T(c)}, &rv); "
+                f"if (k < 0) return k; {R(d)} = rv; {T(d)} = (uint8_t)k; }}")
+    return f"*out = {R(d)}; return {T(d)};"
+
+
+def jit_signature(name: str) -> str:
+    return f"int32_t {name}(const int64_t* a, const uint8_t* at, int64_t* out)"
+
+
+def jit_emit_unit(state: VmState, unit: List[int]) -> str:
+    out = "#include <stdint.h>\n#define I(x) (t[x] == 0 ? r[x] : 0)\n"
+    out += "".join(f"static {jit_signature(f'vitte_jit_f{f}')};\n" for f in unit)
+    for f in unit:
+        func = state.functions[f]
+        params, slots = func.param_count, func.param_count + func.local_count
+        size = max(slots, 1)
+        out += f"static {jit_signature(f'vitte_jit_f{f}')}\n{{\n"
+        out += f"    int64_t r[{size}]; uint8_t t[{size}];\n"
+        out += f"    for (int i = 0; i < {params}; i++) {{ r[i] = a[i]; t[i] = at[i]; }}\n"
+        out += f"    for (int i = {params}; i < {slots}; i++) {{ r[i] = 0; t[i] = 2; }}\n"
+        insts = jit_decode_function(state, f)
+        targets = {dest for _, _, _, dest in insts if dest >= 0}
+        for opcode, ops, pc, dest in insts:
+            prefix = f"L{pc}: " if pc in targets else "    "
+            out += f"{prefix}{jit_emit_inst(state, opcode, ops, dest)}\n"
+        out += "    return -1;\n}\n"
+    return out + f"{jit_signature(f'vitte_jit_entry_f{unit[0]}')} {{ return vitte_jit_f{unit[0]}(a, at, out); }}\n"
+
+
+def host_compile_c(source: str, symbol: str):
+    # Host bridge used by the tests: cc -shared + dlopen, as an embedder would.
+    workdir = tempfile.mkdtemp(prefix="vitte-jit-")
+    src, lib = os.path.join(workdir, "unit.c"), os.path.join(workdir, "unit.so")
+    with open(src, "w") as handle:
+        handle.write(source)
+    built = subprocess.run(["cc", "-O2", "-Wall", "-Werror", "-shared", "-fPIC", "-o", lib, src], capture_output=True)
+    if built.returncode != 0:
+        return None
+    entry = getattr(ctypes.CDLL(lib), symbol)
+    entry.restype = ctypes.c_int32
+    return entry
+
+
+def tier_up(state: VmState, f: int) -> bool:
+    tier = state.tier
+    if tier is None:
+        return False
+    if f not in tier.native and tier.tick(f):
+        unit = jit_collect(state, f)
+        # vm_tier_compile : chaque membre passe aussi par la validation de l'interpréteur.
+        for g in unit:
+            if state.func_entry[g] < 0 and predecode_function(state, g):
+                unit = []
+                break
+        tier.native[f] = tier.compile_c(jit_emit_unit(state, unit), f"vitte_jit_entry_f{f}") if unit else None
+    return tier.native.get(f) is not None
+
+
+def tier_back_edge(state: VmState, f: int) -> None:
+    if state.tier is not None and f not in state.tier.native and state.tier.tick(f):
+        tier_up(state, f)
+
+
+def call_native(state: VmState, f: int, args: List[VmValue]) -> VmValue | None:
+    kinds = {VmValueTag.I64: JIT_T_INT, VmValueTag.BOOL: JIT_T_BOOL, VmValueTag.NIL: JIT_T_NIL}
+    if any(arg.tag not in kinds for arg in args):
+        return None
+    n = max(len(args), 1)
+    raw = (ctypes.c_int64 * n)(*[int(arg.value or 0) for arg in args])
+    types = (ctypes.c_uint8 * n)(*[kinds[arg.tag] for arg in args])
+    out = ctypes.c_int64(0)
+    status = state.tier.native[f](raw, types, ctypes.byref(out))
+    if status == JIT_DEOPT:
+        state.tier.deopts += 1
+        return None
+    state.tier.native_calls += 1
+    if status == JIT_T_INT:
+        return VmValue(VmValueTag.I64, out.value)
+    if status == JIT_T_BOOL:
+        return VmValue(VmValueTag.BOOL, out.value != 0)
+    return VmValue(VmValueTag.NIL, None)
+
+
+# Mapped loader (mirror of vitte.runtime.loader): strings stay views into the file.
+NGRAM_MAX = 8
+
+
+@dataclass
+class NgramProfile:
+    n: int
+    window: int = 0
+    filled: int = 0
+    last_at: int = -1
+    counts: dict = field(default_factory=dict)
+
+    def record(self, at: int, opcode: int) -> None:
+        # Straight-line only: a taken jump, call or return restarts the window.
+        if at != self.last_at + 1:
+            self.filled = 0
+        self.last_at = at
+        self.window = ((self.window << 8) | opcode) & ((1 << 64) - 1)
+        self.filled = min(self.filled + 1, self.n)
+        if self.filled == self.n:
+            key = self.window & ((1 << (8 * self.n)) - 1)
+            self.counts[key] = self.counts.get(key, 0) + 1
+
+    def top(self, k: int) -> List[tuple[List[int], int]]:
+        ranked = sorted(self.counts.items(), key=lambda kv: -kv[1])[:k]
+        return [([(key >> (8 * i)) & 0xFF for i in range(self.n - 1, -1, -1)], count) for key, count in ranked]
+
+
+PROFILE_CHECK_EVERY = 256
+
+
+@dataclass
+class VmProfile:
+    # Mirror of vitte.runtime.profile: clock-driven stack samples checked every
+    # PROFILE_CHECK_EVERY dispatches, plus exact per-opcode / per-function counts.
+    sampling: bool = False
+    counting: bool = False
+    interval_ns: int = 1_000_000
+    clock: Callable[[], int] = time.monotonic_ns
+    countdown: int = PROFILE_CHECK_EVERY
+    start_ns: int = 0
+    next_ns: int = 0
+    stacks: dict = field(default_factory=dict)   # tuple of (func, byte_pc), root first -> weight
+    op_counts: dict = field(default_factory=dict)
+    func_insts: dict = field(default_factory=dict)
+    func_calls: dict = field(default_factory=dict)
+
+    def __post_init__(self) -> None:
+        if self.sampling:
+            self.start_ns = self.clock()
+            self.next_ns = self.start_ns + self.interval_ns
+
+    def due(self) -> int:
+        self.countdown -= 1
+        if self.countdown > 0:
+            return 0
+        self.countdown = PROFILE_CHECK_EVERY
+        now = self.clock()
+        if now < self.next_ns:
+            return 0
+        periods = (now - self.next_ns) // self.interval_ns + 1
+        self.next_ns += periods * self.interval_ns
+        return periods
+
+    def tick(self, state: VmState, frame: VmFrame, opcode: int) -> None:
+        if self.counting:
+            self.op_counts[opcode] = self.op_counts.get(opcode, 0) + 1
+            self.func_insts[frame.func_index] = self.func_insts.get(frame.func_index, 0) + 1
+        if self.sampling:
+            weight = self.due()
+            if weight:
+                stack = tuple((f.func_index, state.insts[f.pc].byte_pc) for f in state.frames[:state.frame_depth])
+                self.stacks[stack] = self.stacks.get(stack, 0) + weight
+
+    @property
+    def samples(self) -> int:
+        return sum(self.stacks.values())
+
+    def folded(self, names: List[str]) -> str:
+        merged: dict = {}
+        for stack, weight in self.stacks.items():
+            line = ";".join(names[f] for f, _ in stack)
+            merged[line] = merged.get(line, 0) + weight
+        return "".join(f"{line} {weight}\n" for line, weight in merged.items())
+
+    def pprof(self, names: List[str]) -> bytes:
+        strings = {"": 0}
+
+        def sid(text: str) -> int:
+            return strings.setdefault(text, len(strings))
+
+        def varint(v: int) -> bytes:
+            out = bytearray()
+            while v >= 0x80:
+                out.append((v & 0x7F) | 0x80)
+                v >>= 7
+            out.append(v)
+            return bytes(out)
+
+        def uint(fieldno: int, v: int) -> bytes:
+            return varint(fieldno << 3) + varint(v)
+
+        def msg(fieldno: int, body: bytes) -> bytes:
+            return varint(fieldno << 3 | 2) + varint(len(body)) + body
+
+        def value_type(kind: str, unit: str) -> bytes:
+            return uint(1, sid(kind)) + uint(2, sid(unit))
+
+        out = msg(1, value_type("samples", "count")) + msg(1, value_type("cpu", "nanoseconds"))
+        loc_ids: dict = {}
+        for stack, weight in self.stacks.items():
+            locs = b"".join(varint(loc_ids.setdefault(fr, len(loc_ids) + 1)) for fr in reversed(stack))
+            values = varint(weight) + varint(weight * self.interval_ns)
+            out += msg(2, msg(1, locs) + msg(2, values))
+        funcs: List[int] = []
+        for (f, pc), loc_id in loc_ids.items():
+            out += msg(4, uint(1, loc_id) + uint(3, pc) + msg(4, uint(1, f + 1)))
+            if f not in funcs:
+                funcs.append(f)
+        for f in funcs:
+            name = sid(names[f])
+            out += msg(5, uint(1, f + 1) + uint(2, name) + uint(3, name))
+        period_type = value_type("cpu", "nanoseconds")
+        for text in strings:
+            out += msg(6, text.encode("utf-8"))
+        return out + uint(10, self.clock() - self.start_ns) + msg(11, period_type) + uint(12, self.interval_ns)
+
+
+PEEP_JUMPS = (Opcode.OP_JMP, Opcode.OP_JMP_IF, Opcode.OP_CMP_LT_JMP, Opcode.OP_R_JMP_IF)
+
+
+def peephole_function(code: List[int]) -> tuple[List[int], int]:
+    insts: List[list] = []  # [opcode, operands, target]
+    pcs: List[int] = []
+    index_of_pc = {}
+    pc = 0
+    while pc < len(code):
+        opcode, operands, size = decode_at_pc(code, pc)
+        index_of_pc[pc] = len(insts)
+        pcs.append(pc)
+        insts.append([opcode, operands, -1])
+        pc += size
+    size_of = lambda inst: 2 + 4 * len(inst[1])
+    rel_at = lambda opcode: 1 if opcode is Opcode.OP_R_JMP_IF else 0
+    labels = set()
+    for i, inst in enumerate(insts):
+        if inst[0] in PEEP_JUMPS:
+            inst[2] = index_of_pc[pcs[i] + size_of(inst) + inst[1][rel_at(inst[0])]]
+            labels.add(inst[2])
+
+    def free_run(start: int, width: int) -> bool:
+        return start + width <= len(insts) and not any(j in labels for j in range(start + 1, start + width))
+
+    def ops(start: int, *expected: Opcode) -> bool:
+        return free_run(start, len(expected)) and all(insts[start + j][0] is e for j, e in enumerate(expected))
+
+    out: List[list] = []
+    old_to_new: List[int] = []
+    fused = 0
+    i = 0
+    while i < len(insts):
+        cur = insts[i]
+        width, repl = 1, cur
+        if ops(i, Opcode.OP_LOAD_LOCAL, Opcode.OP_CONST, Opcode.OP_ADD, Opcode.OP_STORE_LOCAL) and insts[i + 3][1][0] == cur[1][0]:
+            width, repl = 4, [Opcode.OP_INC_LOCAL, [cur[1][0], insts[i + 1][1][0]], -1]
+        elif ops(i, Opcode.OP_CMP_LT, Opcode.OP_JMP_IF):
+            width, repl = 2, [Opcode.OP_CMP_LT_JMP, [0], insts[i + 1][2]]
+        elif ops(i, Opcode.OP_LOAD_LOCAL, Opcode.OP_LOAD_LOCAL):
+            width, repl = 2, [Opcode.OP_LOAD_LOCAL2, [cur[1][0], insts[i + 1][1][0]], -1]
+        fused += width > 1
+        old_to_new.extend([len(out)] * width)
+        out.append(repl)
+        i += width
+    new_pc = []
+    at = 0
+    for inst in out:
+        new_pc.append(at)
+        at += size_of(inst)
+    result: List[int] = []
+    for i, inst in enumerate(out):
+        operands = list(inst[1])
+        if inst[0] in PEEP_JUMPS:
+            operands[rel_at(inst[0])] = new_pc[old_to_new[inst[2]]] - (new_pc[i] + size_of(inst))
+        result += encode_inst(inst[0], *operands)
+    return result, fused
+
+
+LVM_MAGIC = 0x304D564C
+
+
+def encode_chunk(consts: List[Const], functions: List[FunctionEntry], code: List[int], debug: List[int],
+                 version_minor: int = LVM_MINOR_MVP) -> bytes:
+    pool = bytearray()
+    for c in consts:
+        pool += bytes([int(c.tag), 0, 0, 0])
+        if c.tag is ConstTag.I64:
+            pool += struct.pack("<q", c.value)
+        elif c.tag is ConstTag.STRING:
+            raw = c.value.encode("utf-8")
+            pool += struct.pack("<I", len(raw)) + raw
+    table = b"".join(struct.pack("<IIIHHHH", f.name_const, f.code_offset, f.code_size, f.param_count,
+                                 f.local_count, f.max_stack, f.flags) for f in functions)
+    sections = [(1, bytes(pool)), (2, table), (3, bytes(code)), (4, bytes(debug))]
+    offset = 24 + 12 * len(sections)
+    out = bytearray(struct.pack("<IHHIIII", LVM_MAGIC, 0, version_minor, 0, 0, 0, len(sections)))
+    for kind, payload in sections:
+        out += struct.pack("<HHII", kind, 0, offset, len(payload))
+        offset += len(payload)
+    for _, payload in sections:
+        out += payload
+    return bytes(out)
+
+
+def map_chunk(mapping: bytes, load_debug: bool = False) -> tuple[VmState, tuple[int, int]]:
+    magic, major, minor, flags, _, _, count = struct.unpack_from("<IHHIIII", mapping, 0)
+    assert magic == LVM_MAGIC and flags == 0
+    if major != 0 or not LVM_MINOR_MVP <= minor <= LVM_MINOR_COMPACT:
+        raise ValueError(f"unsupported bytecode version {major}.{minor}")
+    spans = {}
+    for s in range(count):
+        kind, _, offset, length = struct.unpack_from("<HHII", mapping, 24 + 12 * s)
+        assert offset + length <= len(mapping)
+        spans[kind] = (offset, length)
+    consts: List[Const] = []
+    at, pool_end = spans[1][0], spans[1][0] + spans[1][1]
+    while at < pool_end:
+        tag = ConstTag(mapping[at])
+        at += 4
+        if tag is ConstTag.I64:
+            consts.append(Const(tag, struct.unpack_from("<q", mapping, at)[0]))
+            at += 8
+        elif tag is ConstTag.STRING:
+            (length,) = struct.unpack_from("<I", mapping, at)
+            consts.append(Const(tag, memoryview(mapping)[at + 4:at + 4 + length]))
+            at += 4 + length
+        else:
+            consts.append(Const(tag, None))
+    functions = [FunctionEntry(*struct.unpack_from("<IIIHHHH", mapping, spans[2][0] + 20 * i))
+                 for i in range(spans[2][1] // 20)]
+    for func in functions:
+        assert func.code_offset + func.code_size <= spans[3][1]
+    state = VmState(consts, functions, list(mapping), code_base=spans[3][0], compact=minor == LVM_MINOR_COMPACT)
+    debug = spans.get(4, (0, 0)) if load_debug else (0, 0)
+    return state, debug
+
+
+# NaN-boxing (mirror of vitte.runtime.nanbox): 16-bit head word selects the tag.
+NB_CANONICAL_NAN = 0x7FF8000000000000
+NB_PAYLOAD_MASK = 0x0000FFFFFFFFFFFF
+NB_TAG_NIL = 0xFFF9
+NB_TAG_BOOL = 0xFFFA
+NB_TAG_INT = 0xFFFB
+NB_TAG_STRING = 0xFFFC
+NB_TAG_ARRAY = 0xFFFD
+NB_TAG_STRUCT = 0xFFFE
+NB_TAG_BIG_INT = 0xFFFF
+NB_INT48_MIN = -(1 << 47)
+NB_INT48_MAX = (1 << 47) - 1
+NB_REF_TAGS = {VmValueTag.STRING: NB_TAG_STRING, VmValueTag.ARRAY: NB_TAG_ARRAY, VmValueTag.STRUCT: NB_TAG_STRUCT}
+
+
+def nb_make(tag: int, payload: int) -> int:
+    return (tag << 48) | (payload & NB_PAYLOAD_MASK)
+
+
+VM_BIG_CACHE_SLOTS = 256
+
+
+def vm_box(heap: List[HeapObject], value: VmValue, big_cache: List[int] | None = None) -> int:
+    if value.tag == VmValueTag.I64:
+        if NB_INT48_MIN <= value.value <= NB_INT48_MAX:
+            return nb_make(NB_TAG_INT, value.value)
+        # vm_box_big_int : cache direct valeur -> HeapI64, revérifié à la lecture.
+        v = value.value
+        slot = (v ^ (v >> 29)) & (VM_BIG_CACHE_SLOTS - 1)
+        if big_cache is not None:
+            cached = big_cache[slot]
+            if 0 <= cached < len(heap) and heap[cached].tag is HeapTag.I64 and heap[cached].payload == v:
+                return nb_make(NB_TAG_BIG_INT, cached)
+        heap.append(HeapObject(HeapTag.I64, v))
+        if big_cache is not None:
+            big_cache[slot] = len(heap) - 1
+        return nb_make(NB_TAG_BIG_INT, len(heap) - 1)
+    if value.tag == VmValueTag.BOOL:
+        return nb_make(NB_TAG_BOOL, 1 if value.value else 0)
+    if value.tag == VmValueTag.F64:
+        if value.value != value.value:
+            return NB_CANONICAL_NAN
+        return struct.unpack("<Q", struct.pack("<d", value.value))[0]
+    if value.tag in NB_REF_TAGS:
+        return nb_make(NB_REF_TAGS[value.tag], value.value)
+    return nb_make(NB_TAG_NIL, 0)
+
+
+def vm_unbox(heap: List[HeapObject], bits: int) -> VmValue:
+    head = bits >> 48
+    payload = bits & NB_PAYLOAD_MASK
+    if head < NB_TAG_NIL:
+        return VmValue(VmValueTag.F64, struct.unpack("<d", struct.pack("<Q", bits))[0])
+    if head == NB_TAG_INT:
+        return VmValue(VmValueTag.I64, payload - (1 << 48) if payload & (1 << 47) else payload)
+    if head == NB_TAG_BIG_INT:
+        return VmValue(VmValueTag.I64, heap[payload].payload)
+    if head == NB_TAG_BOOL:
+        return VmValue(VmValueTag.BOOL, payload == 1)
+    for tag, nb_tag in NB_REF_TAGS.items():
+        if head == nb_tag:
+            return VmValue(tag, payload)
+    return VmValue(VmValueTag.NIL, None)
+
+
+# Generational GC (mirror of vitte.runtime.gc + vm_gc_collect): old gen is
+# heap[0:nursery_start], nursery the rest; survivors are compacted and promoted.
+@dataclass
+class GcGenerations:
+    nursery_start: int = 0
+    remembered: List[int] = field(default_factory=list)
+
+
+GC_REF_TAGS = (VmValueTag.STRING, VmValueTag.ARRAY, VmValueTag.STRUCT)
+
+
+def gc_children(obj: HeapObject) -> List[VmValue]:
+    return obj.payload if obj.tag in (HeapTag.ARRAY, HeapTag.STRUCT) else []
+
+
+def gc_write_barrier(gen: GcGenerations, holder: int, value: VmValue) -> None:
+    if value.tag in GC_REF_TAGS and holder < gen.nursery_start <= value.value and holder not in gen.remembered:
+        gen.remembered.append(holder)
+
+
+def gc_collect(heap: List[HeapObject], gen: GcGenerations, roots: List[VmValue], major: bool) -> None:
+    start = 0 if major else gen.nursery_start
+    marked = [False] * (len(heap) - start)
+    gray: List[int] = []
+
+    def shade(value: VmValue) -> None:
+        if value.tag in GC_REF_TAGS and value.value >= start and not marked[value.value - start]:
+            marked[value.value - start] = True
+            gray.append(value.value)
+
+    for value in roots:
+        shade(value)
+    if not major:
+        for holder in gen.remembered:
+            for child in gc_children(heap[holder]):
+                shade(child)
+    while gray:
+        for child in gc_children(heap[gray.pop()]):
+            shade(child)
+
+    forward: List[int] = []
+    live = start
+    for is_live in marked:
+        forward.append(live if is_live else -1)
+        live += 1 if is_live else 0
+    for k, is_live in enumerate(marked):
+        if is_live:
+            heap[forward[k]] = heap[start + k]
+    del heap[live:]
+
+    def rewrite(value: VmValue) -> None:
+        if value.tag in GC_REF_TAGS and value.value >= start:
+            value.value = forward[value.value - start]
+
+    for value in roots:
+        rewrite(value)
+    for index in list(range(start, live)) + ([] if major else gen.remembered):
+        for child in gc_children(heap[index]):
+            rewrite(child)
+    gen.nursery_start = live
+    gen.remembered = []
+
+
 def heap_alloc(heap: List[HeapObject], tag: HeapTag) -> int:
     heap.append(HeapObject(tag, []))
     return len(heap) - 1
@@ -225,13 +1108,28 @@ def vm_value_from_const(state: VmState, const_index: int, hooks: StdHooks) -> Vm
     if constant.tag is ConstTag.F64:
         return VmValue(VmValueTag.F64, float(constant.value))
     if constant.tag is ConstTag.STRING:
-        rt = hooks.make_string(list(constant.value.encode("utf-8")))
-        ref = heap_alloc(state.heap, HeapTag.STRING)
-        state.heap[ref].payload = list(rt.bytes)
-        return VmValue(VmValueTag.STRING, ref)
+        return VmValue(VmValueTag.STRING, state.const_strings[const_index])
     return VmValue(VmValueTag.NIL, None)
 
 
+def intern_const_strings(state: VmState) -> None:
+    assert not state.heap, "string constants must be interned before any heap allocation"
+    by_text: dict[str, int] = {}
+    state.const_strings = []
+    for constant in state.const_pool:
+        if constant.tag is not ConstTag.STRING:
+            state.const_strings.append(-1)
+            continue
+        # Mapped constants are views into the file; this is their only copy.
+        text = bytes(constant.value).decode("utf-8") if isinstance(constant.value, memoryview) else constant.value
+        if text not in by_text:
+            ref = heap_alloc(state.heap, HeapTag.STRING)
+            state.heap[ref].payload = list(text.encode("utf-8"))
+            by_text[text] = ref
+        state.const_strings.append(by_text[text])
+    state.interned_count = len(state.heap)
+
+
 def vm_render_value_bytes(state: VmState, value: VmValue) -> List[int]:
     if value.tag is VmValueTag.STRING:
         ref = value.value
@@ -250,55 +1148,85 @@ def vm_equals(state: VmState, lhs: VmValue, rhs: VmValue) -> bool:
     if lhs.tag in (VmValueTag.BOOL, VmValueTag.I64, VmValueTag.F64):
         return lhs.value == rhs.value
     if lhs.tag is VmValueTag.STRING:
+        if lhs.value == rhs.value:
+            return True
+        if lhs.value < state.interned_count and rhs.value < state.interned_count:
+            return False
         return vm_render_value_bytes(state, lhs) == vm_render_value_bytes(state, rhs)
     return False
 
 
+R_BINOPS = {
+    Opcode.OP_R_ADD: (VmValueTag.I64, lambda a, b: a + b),
+    Opcode.OP_R_SUB: (VmValueTag.I64, lambda a, b: a - b),
+    Opcode.OP_R_MUL: (VmValueTag.I64, lambda a, b: a * b),
+    Opcode.OP_R_DIV: (VmValueTag.I64, lambda a, b: a // b),
+    Opcode.OP_R_CMP_EQ: (VmValueTag.BOOL, lambda a, b: a == b),
+    Opcode.OP_R_CMP_NE: (VmValueTag.BOOL, lambda a, b: a != b),
+    Opcode.OP_R_CMP_LT: (VmValueTag.BOOL, lambda a, b: a < b),
+    Opcode.OP_R_CMP_LE: (VmValueTag.BOOL, lambda a, b: a <= b),
+    Opcode.OP_R_CMP_GT: (VmValueTag.BOOL, lambda a, b: a > b),
+    Opcode.OP_R_CMP_GE: (VmValueTag.BOOL, lambda a, b: a >= b),
+}
+
+
 def vm_run(state: VmState) -> VmValue:
     hooks = StdHooks(state)
-    if not state.frames:
-        entry = state.functions[0]
-        locals_init = [VmValue(VmValueTag.NIL, None) for _ in range(entry.param_count + entry.local_count)]
-        state.frames.append(VmFrame(0, entry.code_offset, locals_init, 0))
+    if len(state.func_entry) != len(state.functions):
+        error = predecode(state)
+        if error:
+            raise AssertionError(error)
+    if len(state.const_strings) != len(state.const_pool):
+        intern_const_strings(state)
+    if state.frame_depth == 0:
+        ensure_function(state, 0)
+        locals_base = len(state.stack)
+        state.stack.extend(VmValue(VmValueTag.NIL, None) for _ in range(state.functions[0].param_count))
+        push_frame(state, 0, state.func_entry[0], locals_base)
 
     last = VmValue(VmValueTag.NIL, None)
-    while state.frames:
-        frame_index = len(state.frames) - 1
+    while state.frame_depth:
+        frame_index = state.frame_depth - 1
         frame = state.frames[frame_index]
-        opcode, operands, size = decode_at_pc(state.code, frame.pc)
+        inst = state.insts[frame.pc]
+        opcode, operands = inst.opcode, [inst.operand]
+        if state.ngrams is not None:
+            state.ngrams.record(frame.pc, inst.op_byte)
+        if state.profile is not None:
+            state.profile.tick(state, frame, inst.op_byte)
         if opcode is Opcode.OP_CONST:
             value = vm_value_from_const(state, operands[0], hooks)
             state.stack.append(value)
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_ADD:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, lhs.value + rhs.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_SUB:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, lhs.value - rhs.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_MUL:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, lhs.value * rhs.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_DIV:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, lhs.value // rhs.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_MOD:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, lhs.value % rhs.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_NEG:
             val = state.stack.pop()
             state.stack.append(VmValue(VmValueTag.I64, -val.value))
-            frame.pc += size
+            frame.pc += 1
         elif opcode in (Opcode.OP_CMP_EQ, Opcode.OP_CMP_NE, Opcode.OP_CMP_LT, Opcode.OP_CMP_LE, Opcode.OP_CMP_GT, Opcode.OP_CMP_GE):
             rhs = state.stack.pop()
             lhs = state.stack.pop()
@@ -315,46 +1243,106 @@ def vm_run(state: VmState) -> VmValue:
             else:
                 res = lhs.value >= rhs.value
             state.stack.append(VmValue(VmValueTag.BOOL, res))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_LOAD_LOCAL:
             idx = operands[0]
-            state.stack.append(frame.locals[idx])
-            frame.pc += size
+            state.stack.append(state.stack[frame.locals_base + idx])
+            frame.pc += 1
         elif opcode is Opcode.OP_STORE_LOCAL:
             idx = operands[0]
-            frame.locals[idx] = state.stack.pop()
-            frame.pc += size
+            state.stack[frame.locals_base + idx] = state.stack.pop()
+            frame.pc += 1
+        elif opcode is Opcode.OP_INC_LOCAL:
+            at = frame.locals_base + inst.operand
+            step = vm_value_from_const(state, inst.operand_b, hooks)
+            state.stack[at] = VmValue(VmValueTag.I64, state.stack[at].value + step.value)
+            frame.pc += 1
+        elif opcode is Opcode.OP_LOAD_LOCAL2:
+            state.stack.append(state.stack[frame.locals_base + inst.operand])
+            state.stack.append(state.stack[frame.locals_base + inst.operand_b])
+            frame.pc += 1
         elif opcode is Opcode.OP_ALLOC_HEAP:
-            kind = operands[0]
+            kind, field_count = operands[0] & 0xFF, operands[0] >> 8
             tag = HeapTag.STRING if kind == 0 else HeapTag.ARRAY if kind == 1 else HeapTag.STRUCT
             ref = heap_alloc(state.heap, tag)
+            if tag is HeapTag.STRUCT:
+                state.heap[ref].payload = [VmValue(VmValueTag.NIL, None)] * field_count
+                state.heap[ref].shape = field_count
             state.stack.append(VmValue(VmValueTag.STRING if tag is HeapTag.STRING else VmValueTag.ARRAY if tag is HeapTag.ARRAY else VmValueTag.STRUCT, ref))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_LOAD_FIELD:
             idx = operands[0]
             target = state.stack.pop()
             obj = state.heap[target.value]
+            cache = state.caches[inst.target]
+            if obj.shape < 0 or cache.lookup(obj.shape) < 0:
+                if idx >= len(obj.payload):
+                    raise AssertionError("invalid field load")
+                if obj.shape >= 0:
+                    cache.update(obj.shape, idx)
             state.stack.append(obj.payload[idx])
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_STORE_FIELD:
             idx = operands[0]
             value = state.stack.pop()
             target = state.stack.pop()
             obj = state.heap[target.value]
-            while len(obj.payload) <= idx:
-                obj.payload.append(VmValue(VmValueTag.NIL, None))
+            cache = state.caches[inst.target]
+            if obj.shape < 0 or cache.lookup(obj.shape) < 0:
+                if idx >= len(obj.payload):
+                    obj.payload = obj.payload + [VmValue(VmValueTag.NIL, None)] * (idx + 1 - len(obj.payload))
+                    if obj.tag is HeapTag.STRUCT:
+                        obj.shape = idx + 1
+                if obj.shape >= 0:
+                    cache.update(obj.shape, idx)
             obj.payload[idx] = value
-            state.heap[target.value] = obj
-            frame.pc += size
+            frame.pc += 1
+        elif opcode is Opcode.OP_CALL_INDIRECT:
+            fn_index = state.stack.pop().value
+            cache = state.caches[inst.target]
+            entry = cache.lookup(fn_index)
+            if entry < 0:
+                if not 0 <= fn_index < len(state.functions):
+                    raise AssertionError("invalid indirect call target")
+                ensure_function(state, fn_index)
+                entry = state.func_entry[fn_index]
+                cache.update(fn_index, entry)
+            locals_base = len(state.stack) - state.functions[fn_index].param_count
+            frame.pc += 1
+            state.frames[frame_index] = frame
+            push_frame(state, fn_index, entry, locals_base)
         elif opcode is Opcode.OP_CALL:
             fn_index = operands[0]
-            func = state.functions[fn_index]
-            locals_init = [VmValue(VmValueTag.NIL, None) for _ in range(func.param_count + func.local_count)]
-            for arg in range(func.param_count - 1, -1, -1):
-                locals_init[arg] = state.stack.pop()
-            frame.pc += size
+            entry = resolve_call(state, frame.pc, fn_index)
+            locals_base = len(state.stack) - state.functions[fn_index].param_count
+            if locals_base < frame.stack_base:
+                raise AssertionError("stack underflow on call")
+            frame.pc += 1
             state.frames[frame_index] = frame
-            state.frames.append(VmFrame(fn_index, func.code_offset, locals_init, len(state.stack)))
+            native = call_native(state, fn_index, state.stack[locals_base:]) if tier_up(state, fn_index) else None
+            if native is not None:
+                del state.stack[locals_base:]
+                state.stack.append(native)
+                continue
+            push_frame(state, fn_index, entry, locals_base)
+        elif opcode is Opcode.OP_JMP:
+            if inst.target <= frame.pc:
+                tier_back_edge(state, frame.func_index)
+            frame.pc = inst.target
+        elif opcode is Opcode.OP_JMP_IF:
+            cond = state.stack.pop()
+            if cond.tag is not VmValueTag.BOOL:
+                raise AssertionError("jmp_if expects bool")
+            if cond.value and inst.target <= frame.pc:
+                tier_back_edge(state, frame.func_index)
+            frame.pc = inst.target if cond.value else frame.pc + 1
+        elif opcode is Opcode.OP_CMP_LT_JMP:
+            rhs = state.stack.pop()
+            lhs = state.stack.pop()
+            taken = lhs.value < rhs.value
+            if taken and inst.target <= frame.pc:
+                tier_back_edge(state, frame.func_index)
+            frame.pc = inst.target if taken else frame.pc + 1
         elif opcode is Opcode.OP_STD_PRINT or opcode is Opcode.OP_STD_PRINTLN:
             val = state.stack.pop()
             rt = hooks.make_string(vm_render_value_bytes(state, val))
@@ -363,11 +1351,11 @@ def vm_run(state: VmState) -> VmValue:
             else:
                 hooks.print(rt)
             state.stack.append(val)
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_STD_MAKE_STRING:
             value = vm_value_from_const(state, operands[0], hooks)
             state.stack.append(value)
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_STD_CONCAT_STRING:
             rhs = state.stack.pop()
             lhs = state.stack.pop()
@@ -377,7 +1365,7 @@ def vm_run(state: VmState) -> VmValue:
             ref = heap_alloc(state.heap, HeapTag.STRING)
             state.heap[ref].payload = list(merged.bytes)
             state.stack.append(VmValue(VmValueTag.STRING, ref))
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_STD_ARRAY_PUSH:
             value = state.stack.pop()
             arr = state.stack.pop()
@@ -386,23 +1374,66 @@ def vm_run(state: VmState) -> VmValue:
             state.heap[arr.value].payload.append(value)
             hooks.array_push(RtArray(len(state.heap[arr.value].payload), len(state.heap[arr.value].payload), arr.value), value)
             state.stack.append(arr)
-            frame.pc += size
+            frame.pc += 1
         elif opcode is Opcode.OP_STD_ARRAY_GET:
             idx = state.stack.pop()
             arr = state.stack.pop()
             obj = state.heap[arr.value]
             hooks.array_get(RtArray(len(obj.payload), len(obj.payload), arr.value), idx.value)
             state.stack.append(obj.payload[idx.value])
-            frame.pc += size
-        elif opcode is Opcode.OP_RET:
-            last = state.stack.pop()
-            state.frames.pop()
-            if not state.frames:
+            frame.pc += 1
+        elif opcode is Opcode.OP_RET or opcode is Opcode.OP_R_RET:
+            last = state.stack.pop() if opcode is Opcode.OP_RET else state.stack[frame.locals_base + inst.operand]
+            state.frame_depth -= 1
+            del state.stack[frame.locals_base:]
+            if state.frame_depth == 0:
                 return last
-            state.stack.append(last)
+            if frame.ret_reg >= 0:
+                state.stack[state.frames[state.frame_depth - 1].locals_base + frame.ret_reg] = last
+            else:
+                state.stack.append(last)
+        elif opcode is Opcode.OP_R_MOV:
+            state.stack[frame.locals_base + inst.operand] = state.stack[frame.locals_base + inst.operand_b]
+            frame.pc += 1
+        elif opcode is Opcode.OP_R_CONST:
+            state.stack[frame.locals_base + inst.operand] = vm_value_from_const(state, inst.operand_b, hooks)
+            frame.pc += 1
+        elif opcode in R_BINOPS:
+            lhs = state.stack[frame.locals_base + inst.operand_b].value
+            rhs = state.stack[frame.locals_base + inst.operand_c].value
+            tag, fn = R_BINOPS[opcode]
+            state.stack[frame.locals_base + inst.operand] = VmValue(tag, fn(lhs, rhs))
+            frame.pc += 1
+        elif opcode is Opcode.OP_R_NEG:
+            state.stack[frame.locals_base + inst.operand] = VmValue(VmValueTag.I64, -state.stack[frame.locals_base + inst.operand_b].value)
+            frame.pc += 1
+        elif opcode is Opcode.OP_R_NOT:
+            state.stack[frame.locals_base + inst.operand] = VmValue(VmValueTag.BOOL, not state.stack[frame.locals_base + inst.operand_b].value)
+            frame.pc += 1
+        elif opcode is Opcode.OP_R_JMP_IF:
+            cond = state.stack[frame.locals_base + inst.operand]
+            if cond.tag is not VmValueTag.BOOL:
+                raise AssertionError("jmp_if expects bool")
+            if cond.value and inst.target <= frame.pc:
+                tier_back_edge(state, frame.func_index)
+            frame.pc = inst.target if cond.value else frame.pc + 1
+        elif opcode is Opcode.OP_R_CALL:
+            entry = resolve_call(state, frame.pc, inst.operand_b)
+            func = state.functions[inst.operand_b]
+            args_at = frame.locals_base + inst.operand_c
+            frame.pc += 1
+            state.frames[frame_index] = frame
+            if tier_up(state, inst.operand_b):
+                native = call_native(state, inst.operand_b, state.stack[args_at:args_at + func.param_count])
+                if native is not None:
+                    state.stack[frame.locals_base + inst.operand] = native
+                    continue
+            locals_base = len(state.stack)
+            state.stack.extend(state.stack[args_at:args_at + func.param_count])
+            push_frame(state, inst.operand_b, entry, locals_base, inst.operand)
         else:
             raise AssertionError(f"unhandled opcode {opcode}")
-        if opcode is not Opcode.OP_CALL and opcode is not Opcode.OP_RET:
+        if opcode not in (Opcode.OP_CALL, Opcode.OP_CALL_INDIRECT, Opcode.OP_RET, Opcode.OP_R_CALL, Opcode.OP_R_RET):
             state.frames[frame_index] = frame
     return last
 
@@ -453,6 +1484,40 @@ class VmOpcodeTest(unittest.TestCase):
         self.assertEqual(result.tag, VmValueTag.I64)
         self.assertEqual(result.value, 42)
 
+    def test_recursive_calls_reuse_frame_pool_and_stack_windows(self) -> None:
+        # sum(n) = n == 0 ? 0 : n + sum(n - 1)
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 10)]
+        main_code = encode_inst(Opcode.OP_CONST, 2) + encode_inst(Opcode.OP_CALL, 1) + encode_inst(Opcode.OP_RET)
+        base = encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_RET)
+        step = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_SUB)
+            + encode_inst(Opcode.OP_CALL, 1)
+            + encode_inst(Opcode.OP_ADD)
+            + encode_inst(Opcode.OP_RET)
+        )
+        test = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_CONST, 0)
+            + encode_inst(Opcode.OP_CMP_EQ)
+            + encode_inst(Opcode.OP_JMP_IF, len(step))
+        )
+        sum_code = test + step + base
+        functions = [
+            FunctionEntry(0, 0, len(main_code), 0, 0),
+            FunctionEntry(0, len(main_code), len(sum_code), 1, 0),
+        ]
+        state = make_chunk(consts, main_code + sum_code, functions)
+        self.assertEqual(vm_run(state).value, 55)
+        # main + sum(10..0): the window of each frame was released on return.
+        self.assertEqual(len(state.frames), 12)
+        self.assertEqual(state.stack, [])
+
+        self.assertEqual(vm_run(state).value, 55)
+        self.assertEqual(len(state.frames), 12)
+
     def test_heap_and_std_array_ops(self) -> None:
         consts = [Const(ConstTag.I64, 7), Const(ConstTag.I64, 1)]
         code = (
@@ -477,6 +1542,67 @@ class VmOpcodeTest(unittest.TestCase):
         self.assertEqual(result.tag, VmValueTag.I64)
         self.assertEqual(result.value, 7)
 
+    def test_field_and_indirect_call_sites_use_inline_caches(self) -> None:
+        # p = struct{2 fields}; three rounds of p.0 = p.0 + k, then p.3 = f(p.0) through call_indirect.
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 2)]
+        bump = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_FIELD, 0)
+            + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_ADD)
+            + encode_inst(Opcode.OP_STORE_FIELD, 0)
+        )
+        counter = encode_inst(Opcode.OP_LOAD_LOCAL, 1) + encode_inst(Opcode.OP_CONST, 2) + encode_inst(Opcode.OP_CMP_GT)
+        back_len = len(encode_inst(Opcode.OP_JMP, 0))
+        incr = encode_inst(Opcode.OP_LOAD_LOCAL, 1) + encode_inst(Opcode.OP_CONST, 1) + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_STORE_LOCAL, 1)
+        exit_jump = encode_inst(Opcode.OP_JMP_IF, len(bump) + len(incr) + back_len)
+        back = encode_inst(Opcode.OP_JMP, -(len(counter) + len(exit_jump) + len(bump) + len(incr) + back_len))
+        head = (
+            encode_inst(Opcode.OP_ALLOC_HEAP, 2 | 2 << 8)
+            + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_CONST, 0)
+            + encode_inst(Opcode.OP_STORE_FIELD, 0)
+            + encode_inst(Opcode.OP_CONST, 0)
+            + encode_inst(Opcode.OP_STORE_LOCAL, 1)
+        )
+        tail = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_FIELD, 0)
+            + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_CALL_INDIRECT)
+            + encode_inst(Opcode.OP_STORE_FIELD, 3)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_LOAD_FIELD, 3)
+            + encode_inst(Opcode.OP_RET)
+        )
+        main_code = head + counter + exit_jump + bump + incr + back + tail
+        double = encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_RET)
+        functions = [FunctionEntry(0, 0, len(main_code), 0, 2), FunctionEntry(0, len(main_code), len(double), 1, 0)]
+        state = make_chunk(consts, main_code + double, functions)
+
+        result = vm_run(state)
+        self.assertEqual(result.value, 6)
+        obj = state.heap[0]
+        self.assertEqual((obj.tag, obj.shape, len(obj.payload)), (HeapTag.STRUCT, 4, 4))
+        field_sites = [state.caches[i.target] for i in state.insts if i.opcode is Opcode.OP_LOAD_FIELD]
+        # The loop's load site saw shape 2 once, then hit on the two later rounds.
+        self.assertEqual((field_sites[0].keys, field_sites[0].hits, field_sites[0].misses), ([2], 2, 1))
+        call_site = next(state.caches[i.target] for i in state.insts if i.opcode is Opcode.OP_CALL_INDIRECT)
+        self.assertEqual(call_site.keys, [1])
+
+    def test_inline_cache_goes_megamorphic_after_ic_ways_keys(self) -> None:
+        cache = InlineCache()
+        for shape in range(IC_WAYS):
+            self.assertEqual(cache.lookup(shape), -1)
+            cache.update(shape, shape)
+        self.assertEqual(cache.lookup(IC_WAYS - 1), IC_WAYS - 1)
+        cache.update(IC_WAYS, 0)
+        self.assertTrue(cache.mega)
+        self.assertEqual(cache.lookup(0), -1)
+
     def test_std_string_instructions_and_stub_validation(self) -> None:
         consts = [
             Const(ConstTag.STRING, "hi"),
@@ -499,6 +1625,544 @@ class VmOpcodeTest(unittest.TestCase):
         validation_error = validate_code_bytes(code)
         self.assertEqual(validation_error, "")
 
+    def test_string_constants_are_interned_once(self) -> None:
+        consts = [Const(ConstTag.STRING, "lit"), Const(ConstTag.STRING, "lit"), Const(ConstTag.STRING, "other")]
+        code = (
+            encode_inst(Opcode.OP_CONST, 0)
+            + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_CMP_EQ)
+            + encode_inst(Opcode.OP_CONST, 0)
+            + encode_inst(Opcode.OP_CONST, 2)
+            + encode_inst(Opcode.OP_CMP_NE)
+            + encode_inst(Opcode.OP_CMP_EQ)
+            + encode_inst(Opcode.OP_RET)
+        )
+        state = make_chunk(consts, code)
+        result = vm_run(state)
+        self.assertEqual(result, VmValue(VmValueTag.BOOL, True))
+        # Duplicate literals share one heap object; executing OpConst allocates nothing.
+        self.assertEqual(state.const_strings, [0, 0, 1])
+        self.assertEqual(len(state.heap), 2)
+
+    def test_predecoded_loop_resolves_jump_targets(self) -> None:
+        # local0 = 0 ; while local0 < 5 { local0 = local0 + 1 } ; ret local0
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 5)]
+        init = encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+        cond = encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_CONST, 2) + encode_inst(Opcode.OP_CMP_GE)
+        body = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_ADD)
+            + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+        )
+        back_jump_len = len(encode_inst(Opcode.OP_JMP, 0))
+        exit_jump = encode_inst(Opcode.OP_JMP_IF, len(body) + back_jump_len)
+        back_jump = encode_inst(Opcode.OP_JMP, -(len(cond) + len(exit_jump) + len(body) + back_jump_len))
+        tail = encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_RET)
+        code = init + cond + exit_jump + body + back_jump + tail
+        state = make_chunk(consts, code, [FunctionEntry(0, 0, len(code), 0, 1)])
+
+        self.assertEqual(predecode(state), "")
+        self.assertEqual(len(state.insts), 13)
+        self.assertEqual(state.insts[5].opcode, Opcode.OP_JMP_IF)
+        self.assertEqual(state.insts[5].target, 11)
+        self.assertEqual(state.insts[10].target, 2)
+
+        result = vm_run(state)
+        self.assertEqual(result.tag, VmValueTag.I64)
+        self.assertEqual(result.value, 5)
+
+    def test_predecode_rejects_misaligned_jump(self) -> None:
+        code = encode_inst(Opcode.OP_JMP, 1) + encode_inst(Opcode.OP_RET)
+        state = make_chunk([], code)
+        self.assertEqual(predecode(state), "invalid jump target at byte 0")
+
+    def sum_loop(self) -> tuple[List[Const], List[int]]:
+        # i = 0 ; acc = 0 ; while i < 10 { acc = acc + i ; i = i + 1 } ; ret acc
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 10)]
+        init = (encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+                + encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_STORE_LOCAL, 1))
+        exit_jump_len = len(encode_inst(Opcode.OP_JMP, 0))
+        body = (
+            encode_inst(Opcode.OP_LOAD_LOCAL, 1) + encode_inst(Opcode.OP_LOAD_LOCAL, 0)
+            + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_STORE_LOCAL, 1)
+            + encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_CONST, 1)
+            + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+        )
+        cond = (encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_CONST, 2)
+                + encode_inst(Opcode.OP_CMP_LT) + encode_inst(Opcode.OP_JMP_IF, exit_jump_len))
+        back_len = len(encode_inst(Opcode.OP_JMP, 0))
+        exit_jump = encode_inst(Opcode.OP_JMP, len(body) + back_len)
+        back = encode_inst(Opcode.OP_JMP, -(len(cond) + exit_jump_len + len(body) + back_len))
+        tail = encode_inst(Opcode.OP_LOAD_LOCAL, 1) + encode_inst(Opcode.OP_RET)
+        return consts, init + cond + exit_jump + body + back + tail
+
+    def test_peephole_fuses_superinstructions_and_relinks_jumps(self) -> None:
+        consts, code = self.sum_loop()
+        fused, count = peephole_function(code)
+        self.assertEqual(count, 3)
+        self.assertEqual(validate_code_bytes(fused), "")
+        opcodes, pc = [], 0
+        while pc < len(fused):
+            opcode, _, size = decode_at_pc(fused, pc)
+            opcodes.append(opcode)
+            pc += size
+        for op in (Opcode.OP_INC_LOCAL, Opcode.OP_LOAD_LOCAL2, Opcode.OP_CMP_LT_JMP):
+            self.assertEqual(opcodes.count(op), 1)
+
+        runs = {}
+        for name, body in (("plain", code), ("fused", fused)):
+            state = make_chunk(consts, body, [FunctionEntry(0, 0, len(body), 0, 2)])
+            state.ngrams = NgramProfile(1)
+            result = vm_run(state)
+            self.assertEqual((result.tag, result.value), (VmValueTag.I64, 45))
+            runs[name] = sum(state.ngrams.counts.values())
+        # 4 + 11 * 4 + 1 + 10 * 9 + 2 dispatches before, 4 + 11 * 3 + 1 + 10 * 5 + 2 after.
+        self.assertEqual(runs["plain"], 141)
+        self.assertEqual(runs["fused"], 90)
+
+    def test_peephole_does_not_fuse_across_a_jump_target(self) -> None:
+        # load_local 0 ; [L] load_local 1 ; const 0 ; jmp_if L
+        tail = encode_inst(Opcode.OP_LOAD_LOCAL, 1) + encode_inst(Opcode.OP_CONST, 0)
+        jump_len = len(encode_inst(Opcode.OP_JMP_IF, 0))
+        code = encode_inst(Opcode.OP_LOAD_LOCAL, 0) + tail + encode_inst(Opcode.OP_JMP_IF, -(len(tail) + jump_len))
+        self.assertEqual(peephole_function(code), (code, 0))
+
+    def test_ngram_profile_ranks_straight_line_sequences(self) -> None:
+        consts, code = self.sum_loop()
+        state = make_chunk(consts, code, [FunctionEntry(0, 0, len(code), 0, 2)])
+        state.ngrams = NgramProfile(2)
+        vm_run(state)
+        top = state.ngrams.top(3)
+        self.assertEqual(top[0], ([Opcode.OP_LOAD_LOCAL, Opcode.OP_CONST], 21))
+        self.assertEqual(top[1], ([Opcode.OP_ADD, Opcode.OP_STORE_LOCAL], 20))
+        self.assertEqual(state.ngrams.counts[(Opcode.OP_CMP_LT << 8) | Opcode.OP_JMP_IF], 11)
+        # Taken jumps restart the window: no bigram spans jmp -> loop head.
+        self.assertNotIn((Opcode.OP_JMP << 8) | Opcode.OP_LOAD_LOCAL, state.ngrams.counts)
+
+    def test_ngram_profile_records_opcodes_not_wide_prefixes(self) -> None:
+        # const 300 needs a 16-bit operand: its first byte in the 0.2 encoding is LVM_WIDE16.
+        consts = [Const(ConstTag.I64, i) for i in range(301)]
+        code = (encode_inst(Opcode.OP_CONST, 300) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+                + encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_RET))
+        state = self.compact_state(consts, [FunctionEntry(0, 0, len(code), 0, 1)], code)
+        self.assertEqual(state.code[0], LVM_WIDE16)
+        state.ngrams = NgramProfile(2)
+        vm_run(state)
+        self.assertEqual(state.ngrams.counts[(Opcode.OP_CONST << 8) | Opcode.OP_STORE_LOCAL], 1)
+        self.assertFalse(any((key >> 8) in (LVM_WIDE16, LVM_WIDE32) or (key & 0xFF) in (LVM_WIDE16, LVM_WIDE32)
+                             for key in state.ngrams.counts))
+
+    def test_count_ops_counts_opcodes_functions_and_calls(self) -> None:
+        # main: f(f(42)) ; f(x) = x + 1
+        consts = [Const(ConstTag.STRING, "main"), Const(ConstTag.I64, 1), Const(ConstTag.STRING, "f"), Const(ConstTag.I64, 42)]
+        main_code = (encode_inst(Opcode.OP_CONST, 3) + encode_inst(Opcode.OP_CALL, 1)
+                     + encode_inst(Opcode.OP_CALL, 1) + encode_inst(Opcode.OP_RET))
+        callee = (encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_CONST, 1)
+                  + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_RET))
+        functions = [FunctionEntry(0, 0, len(main_code), 0, 0), FunctionEntry(2, len(main_code), len(callee), 1, 0)]
+        state = make_chunk(consts, main_code + callee, functions)
+        state.profile = VmProfile(counting=True)
+        self.assertEqual(vm_run(state).value, 44)
+        self.assertEqual(state.profile.func_insts, {0: 4, 1: 8})
+        self.assertEqual(state.profile.func_calls, {0: 1, 1: 2})
+        self.assertEqual(state.profile.op_counts, {
+            Opcode.OP_CONST: 3, Opcode.OP_CALL: 2, Opcode.OP_LOAD_LOCAL: 2, Opcode.OP_ADD: 2, Opcode.OP_RET: 3,
+        })
+
+    def sampled_loop(self) -> VmState:
+        consts, code = self.sum_loop()
+        consts[2] = Const(ConstTag.I64, 1000)
+        state = make_chunk(consts, code, [FunctionEntry(0, 0, len(code), 0, 2)])
+        ticks = iter(range(0, 10**9, 1000))
+        # Each clock read is one interval later: every check is due, with weight 1.
+        state.profile = VmProfile(sampling=True, interval_ns=1000, clock=lambda: next(ticks))
+        return state
+
+    def test_count_ops_counts_wide_instructions_under_their_opcode(self) -> None:
+        consts = [Const(ConstTag.I64, i) for i in range(301)]
+        code = (encode_inst(Opcode.OP_CONST, 300) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+                + encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_RET))
+        state = self.compact_state(consts, [FunctionEntry(0, 0, len(code), 0, 1)], code)
+        self.assertEqual(state.code[0], LVM_WIDE16)
+        state.profile = VmProfile(counting=True)
+        vm_run(state)
+        self.assertEqual(state.profile.op_counts, {Opcode.OP_CONST: 1, Opcode.OP_STORE_LOCAL: 1,
+                                                   Opcode.OP_LOAD_LOCAL: 1, Opcode.OP_RET: 1})
+
+    def test_sampling_profile_reads_the_clock_every_check_interval(self) -> None:
+        state = self.sampled_loop()
+        self.assertEqual(vm_run(state).value, 499500)
+        # 4 + 1001 * 4 + 1 + 1000 * 9 + 2 dispatches, one clock read per 256.
+        self.assertEqual(state.profile.samples, 13011 // PROFILE_CHECK_EVERY)
+        self.assertTrue(all(len(stack) == 1 and stack[0][0] == 0 for stack in state.profile.stacks))
+        self.assertEqual(state.profile.folded(["main"]), "main 50\n")
+
+    def test_sampling_profile_weights_late_checks_by_elapsed_periods(self) -> None:
+        profile = VmProfile(sampling=True, interval_ns=100, clock=iter([0, 1050]).__next__)
+        profile.countdown = 1
+        self.assertEqual(profile.due(), 10)
+        self.assertEqual(profile.next_ns, 1100)
+
+    def test_pprof_output_is_a_profile_proto(self) -> None:
+        state = self.sampled_loop()
+        vm_run(state)
+        data = state.profile.pprof(["main"])
+
+        def varint(at: int) -> tuple[int, int]:
+            v = shift = 0
+            while True:
+                b = data[at]
+                v |= (b & 0x7F) << shift
+                at += 1
+                shift += 7
+                if b < 0x80:
+                    return v, at
+
+        fields: dict = {}
+        at = 0
+        while at < len(data):
+            key, at = varint(at)
+            if key & 7 == 2:
+                size, at = varint(at)
+                value, at = data[at:at + size], at + size
+            else:
+                value, at = varint(at)
+            fields.setdefault(key >> 3, []).append(value)
+        strings = [bytes(v).decode() for v in fields[6]]
+        self.assertEqual(strings[0], "")
+        self.assertIn("main", strings)
+        self.assertEqual(len(fields[1]), 2)                          # samples/count, cpu/nanoseconds
+        self.assertEqual(len(fields[2]), len(state.profile.stacks))  # one Sample per distinct stack
+        self.assertEqual(len(fields[5]), 1)                          # one Function
+        self.assertEqual(fields[12], [1000])
+
+    def test_mapped_chunk_keeps_string_views_and_skips_debug(self) -> None:
+        consts = [Const(ConstTag.STRING, "mapped"), Const(ConstTag.I64, 9)]
+        code = encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_STD_PRINTLN) + encode_inst(Opcode.OP_CONST, 1) + encode_inst(Opcode.OP_RET)
+        mapping = encode_chunk(consts, [FunctionEntry(0, 0, len(code), 0, 0)], code, [0xDE, 0xAD])
+
+        state, debug = map_chunk(mapping)
+        self.assertIsInstance(state.const_pool[0].value, memoryview)
+        self.assertEqual(debug, (0, 0))
+        self.assertEqual(map_chunk(mapping, load_debug=True)[1][1], 2)
+
+        predecode(state, lazy=True)
+        result = vm_run(state)
+        self.assertEqual(result.value, 9)
+        self.assertEqual(state.printed, ["mapped\n"])
+
+    def test_lazy_predecode_validates_functions_on_first_call(self) -> None:
+        consts = [Const(ConstTag.I64, 1)]
+        main_code = encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_RET)
+        broken = encode_inst(Opcode.OP_JMP, 1) + encode_inst(Opcode.OP_RET)
+        functions = [FunctionEntry(0, 0, len(main_code), 0, 0), FunctionEntry(0, len(main_code), len(broken), 0, 0)]
+
+        state = make_chunk(consts, main_code + broken, functions)
+        predecode(state, lazy=True)
+        self.assertEqual(vm_run(state).value, 1)
+        self.assertEqual(state.func_entry, [0, -1])
+
+        calling = encode_inst(Opcode.OP_CALL, 1) + encode_inst(Opcode.OP_RET)
+        functions = [FunctionEntry(0, 0, len(calling), 0, 0), FunctionEntry(0, len(calling), len(broken), 0, 0)]
+        state = make_chunk(consts, calling + broken, functions)
+        predecode(state, lazy=True)
+        with self.assertRaises(AssertionError):
+            vm_run(state)
+
+    def compact_state(self, consts: List[Const], functions: List[FunctionEntry], code: List[int]) -> VmState:
+        entries, packed = compact_chunk(functions, code)
+        return VmState(consts, entries, packed, compact=True)
+
+    def test_compact_encoding_shrinks_code_and_keeps_results(self) -> None:
+        consts, code = self.sum_loop()
+        fused, _ = peephole_function(code)
+        for body in (code, fused):
+            state = self.compact_state(consts, [FunctionEntry(0, 0, len(body), 0, 2)], body)
+            self.assertLessEqual(len(state.code) * 5, len(body) * 2)
+            self.assertNotIn(LVM_WIDE16, state.code)
+            self.assertEqual(predecode(state), "")
+            for inst in state.insts:
+                if inst.opcode in PEEP_JUMPS:
+                    self.assertEqual(state.insts[inst.target].byte_pc % LVM_JUMP_ALIGN, 0)
+            self.assertEqual(vm_run(state).value, 45)
+
+    def test_compact_widens_large_operands_and_far_jumps(self) -> None:
+        # const 300 ; store_local 0 ; jmp over 300 words ; load_local 0 ; ret
+        consts = [Const(ConstTag.I64, i) for i in range(301)]
+        filler = (encode_inst(Opcode.OP_CONST, 1) + encode_inst(Opcode.OP_STORE_LOCAL, 1)) * 300
+        code = (encode_inst(Opcode.OP_CONST, 300) + encode_inst(Opcode.OP_STORE_LOCAL, 0)
+                + encode_inst(Opcode.OP_JMP, len(filler)) + filler
+                + encode_inst(Opcode.OP_LOAD_LOCAL, 0) + encode_inst(Opcode.OP_RET))
+        state = self.compact_state(consts, [FunctionEntry(0, 0, len(code), 0, 2)], code)
+        self.assertEqual(state.code[:4], [LVM_WIDE16, Opcode.OP_CONST, 300 & 0xFF, 300 >> 8])
+        self.assertEqual(state.code[6:10], [LVM_WIDE16, Opcode.OP_JMP, 300 & 0xFF, 300 >> 8])
+        self.assertEqual(vm_run(state).value, 300)
+        self.assertEqual(len(state.insts), 2 + 1 + 600 + 2)
+
+    def test_mapped_chunks_of_both_versions_load(self) -> None:
+        consts = [Const(ConstTag.I64, 1), Const(ConstTag.I64, 2)]
+        main_code = (encode_inst(Opcode.OP_CONST, 0) + encode_inst(Opcode.OP_CALL, 1)
+                     + encode_inst(Opcode.OP_ADD) + encode_inst(Opcode.OP_RET))
+        callee = encode_inst(Opcode.OP_CONST, 1) + encode_inst(Opcode.OP_RET)
+        functions = [FunctionEntry(0, 0, len(main_code), 0, 0), FunctionEntry(0, len(main_code), len(callee), 0, 0)]
+        entries, packed = compact_chunk(functions, main_code + callee)
+        self.assertEqual(entries[1].code_offset % LVM_JUMP_ALIGN, 0)
+        for version, table, body in ((LVM_MINOR_MVP, functions, main_code + callee), (LVM_MINOR_COMPACT, entries, packed)):
+            state, _ = map_chunk(encode_chunk(consts, table, body, [], version))
+            self.assertEqual(state.compact, version == LVM_MINOR_COMPACT)
+            predecode(state, lazy=True)
+            self.assertEqual(vm_run(state).value, 3)
+        with self.assertRaises(ValueError):
+            map_chunk(encode_chunk(consts, functions, main_code + callee, [], 3))
+
+    def test_compact_predecode_rejects_truncated_wide_instruction(self) -> None:
+        code = [LVM_WIDE16, int(Opcode.OP_CONST), 0]
+        state = VmState([Const(ConstTag.I64, 0)], [FunctionEntry(0, 0, len(code), 0, 0)], code, compact=True)
+        self.assertEqual(predecode(state), "instruction at byte 0 truncated")
+
+    def test_register_mode_loop_and_call(self) -> None:
+        # main: r0 = i, r1 = acc, r2 = n ; while i < n { acc = twice(i) + acc ; i = i + 1 }
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 4)]
+        head = (
+            encode_inst(Opcode.OP_R_CONST, 0, 0)
+            + encode_inst(Opcode.OP_R_CONST, 1, 0)
+            + encode_inst(Opcode.OP_R_CONST, 2, 2)
+            + encode_inst(Opcode.OP_R_CONST, 3, 1)
+        )
+        cond = encode_inst(Opcode.OP_R_CMP_LT, 4, 0, 2)
+        jmp_len = len(encode_inst(Opcode.OP_JMP, 0))
+        body = (
+            encode_inst(Opcode.OP_R_MOV, 5, 0)
+            + encode_inst(Opcode.OP_R_CALL, 6, 1, 5)
+            + encode_inst(Opcode.OP_R_ADD, 1, 6, 1)
+            + encode_inst(Opcode.OP_R_ADD, 0, 0, 3)
+        )
+        enter = encode_inst(Opcode.OP_R_JMP_IF, 4, jmp_len)
+        leave = encode_inst(Opcode.OP_JMP, len(body) + jmp_len)
+        back = encode_inst(Opcode.OP_JMP, -(len(cond) + len(enter) + len(leave) + len(body) + jmp_len))
+        tail = encode_inst(Opcode.OP_R_RET, 1)
+        main_code = head + cond + enter + leave + body + back + tail
+        twice_code = encode_inst(Opcode.OP_R_ADD, 1, 0, 0) + encode_inst(Opcode.OP_R_RET, 1)
+        code = main_code + twice_code
+        functions = [
+            FunctionEntry(0, 0, len(main_code), 0, 7, flags=FFLAG_REGISTER),
+            FunctionEntry(0, len(main_code), len(twice_code), 1, 1, flags=FFLAG_REGISTER),
+        ]
+        self.assertEqual(validate_code_bytes(code), "")
+        state = make_chunk(consts, code, functions)
+        result = vm_run(state)
+        self.assertEqual(result.tag, VmValueTag.I64)
+        self.assertEqual(result.value, 2 * (0 + 1 + 2 + 3))
+        self.assertEqual(state.stack, [])
+
+    @unittest.skipUnless(shutil.which("cc"), "needs a C compiler for the native tier")
+    def test_hot_register_functions_run_through_the_native_tier(self) -> None:
+        # main: acc = 0 ; for i in 0..n { acc = acc + poly(i) } with poly(x) = twice(x) * x - 3, all register mode.
+        consts = [Const(ConstTag.I64, 0), Const(ConstTag.I64, 1), Const(ConstTag.I64, 40), Const(ConstTag.I64, 3)]
+        head = (
+            encode_inst(Opcode.OP_R_CONST, 0, 0)
+            + encode_inst(Opcode.OP_R_CONST, 1, 0)
+            + encode_inst(Opcode.OP_R_CONST, 2, 2)
+            + encode_inst(Opcode.OP_R_CONST, 3, 1)
+        )
+        cond = encode_inst(Opcode.OP_R_CMP_LT, 4, 0, 2)
+        jmp_len = len(encode_inst(Opcode.OP_JMP, 0))
+        body = (
+            encode_inst(Opcode.OP_R_MOV, 5, 0)
+            + encode_inst(Opcode.OP_R_CALL, 6, 1, 5)
+            + encode_inst(Opcode.OP_R_ADD, 1, 6, 1)
+            + encode_inst(Opcode.OP_R_ADD, 0, 0, 3)
+        )
+        enter = encode_inst(Opcode.OP_R_JMP_IF, 4, jmp_len)
+        leave = encode_inst(Opcode.OP_JMP, len(body) + jmp_len)
+        back = encode_inst(Opcode.OP_JMP, -(len(cond) + len(enter) + len(leave) + len(body) + jmp_len))
+        main_code = head + cond + enter + leave + body + back + encode_inst(Opcode.OP_R_RET, 1)
+        poly_code = (
+            encode_inst(Opcode.OP_R_CALL, 1, 2, 0)
+            + encode_inst(Opcode.OP_R_MUL, 1, 1, 0)
+            + encode_inst(Opcode.OP_R_CONST, 2, 3)
+            + encode_inst(Opcode.OP_R_SUB, 1, 1, 2)
+            + encode_inst(Opcode.OP_R_RET, 1)
+        )
+        twice_code = encode_inst(Opcode.OP_R_ADD, 1, 0, 0) + encode_inst(Opcode.OP_R_RET, 1)
+        poly_at = len(main_code)
+        functions = [
+            FunctionEntry(0, 0, len(main_code), 0, 7, flags=FFLAG_REGISTER),
+            FunctionEntry(0, poly_at, len(poly_code), 1, 2, flags=FFLAG_REGISTER),
+            FunctionEntry(0, poly_at + len(poly_code), len(twice_code), 1, 1, flags=FFLAG_REGISTER),
+        ]
+        code = main_code + poly_code + twice_code
+        expected = sum(2 * x * x - 3 for x in range(40))
+
+        state = make_chunk(consts, code, functions)
+        state.tier = JitTier(host_compile_c, threshold=10)
+        result = vm_run(state)
+        self.assertEqual(result, VmValue(VmValueTag.I64, expected))
+        # poly turns hot on its 10th call; the unit also carries twice as a static callee.
+        self.assertEqual(state.tier.native_calls, 31)
+        self.assertIn("static int32_t vitte_jit_f2(", jit_emit_unit(state, jit_collect(state, 1)))
+        # main's loop crossed the threshold via back-edges too, but it is only entered once.
+        self.assertIsNotNone(state.tier.native[0])
+
+        # Same unit from the compact encoding: word offsets resolve to the same labels.
+        state = self.compact_state(consts, functions, code)
+        state.tier = JitTier(host_compile_c, threshold=10)
+        self.assertEqual(vm_run(state), VmValue(VmValueTag.I64, expected))
+        self.assertEqual(state.tier.native_calls, 31)
+
+        functions[1].flags |= FFLAG_NOJIT
+        state = make_chunk(consts, code, functions)
+        state.tier = JitTier(host_compile_c, threshold=10)
+        self.assertEqual(vm_run(state), VmValue(VmValueTag.I64, expected))
+        # poly stays interpreted; twice, now called from the interpreter, goes native by itself.
+        self.assertIsNone(state.tier.native[1])
+        self.assertIsNotNone(state.tier.native[2])
+
+    @unittest.skipUnless(shutil.which("cc"), "needs a C compiler for the native tier")
+    def test_native_tier_deopts_to_the_interpreter(self) -> None:
+        consts = [Const(ConstTag.I64, 7)]
+        div_code = encode_inst(Opcode.OP_R_DIV, 2, 0, 1) + encode_inst(Opcode.OP_R_RET, 2)
+        state = make_chunk(consts, div_code, [FunctionEntry(0, 0, len(div_code), 2, 1, flags=FFLAG_REGISTER)])
+        state.tier = JitTier(host_compile_c, threshold=1)
+        predecode(state)
+        tier_up(state, 0)
+        self.assertEqual(call_native(state, 0, [VmValue(VmValueTag.I64, 42), VmValue(VmValueTag.I64, 6)]), VmValue(VmValueTag.I64, 7))
+        # Division by zero and non-scalar arguments are left to the interpreter.
+        self.assertIsNone(call_native(state, 0, [VmValue(VmValueTag.I64, 1), VmValue(VmValueTag.I64, 0)]))
+        self.assertIsNone(call_native(state, 0, [VmValue(VmValueTag.STRING, 0), VmValue(VmValueTag.I64, 1)]))
+        self.assertEqual(state.tier.deopts, 1)
+
+    def test_native_tier_rejects_malformed_callees_that_never_ran(self) -> None:
+        # main: r0 = true ; if r0 skip { r1 = callee(r0) } ; r1 = 7 ; ret r1 — the callee is never executed.
+        consts = [Const(ConstTag.BOOL, True), Const(ConstTag.I64, 7)]
+        call = encode_inst(Opcode.OP_R_CALL, 1, 1, 0)
+        main_code = (encode_inst(Opcode.OP_R_CONST, 0, 0) + encode_inst(Opcode.OP_R_JMP_IF, 0, len(call)) + call
+                     + encode_inst(Opcode.OP_R_CONST, 1, 1) + encode_inst(Opcode.OP_R_RET, 1))
+        # Callee bodies as (MVP bytes, compact bytes): the compact packer itself refuses to emit them.
+        rret, rconst, jmp = int(Opcode.OP_R_RET), int(Opcode.OP_R_CONST), int(Opcode.OP_JMP)
+        callees = {
+            "truncated": (encode_inst(Opcode.OP_R_RET, 0)[:3], [LVM_WIDE16]),
+            "register out of window": (encode_inst(Opcode.OP_R_RET, 5), [rret, 5]),
+            "const out of range": (encode_inst(Opcode.OP_R_CONST, 0, 9) + encode_inst(Opcode.OP_R_RET, 0), [rconst, 0, 9, rret, 0]),
+            "bad jump target": (encode_inst(Opcode.OP_JMP, 1) + encode_inst(Opcode.OP_R_RET, 0), [jmp, 1, rret, 0]),
+        }
+        compiled: List[str] = []
+        main_entry = FunctionEntry(0, 0, len(main_code), 0, 2, flags=FFLAG_REGISTER)
+        for name, (mvp, packed_callee) in callees.items():
+            for compact in (False, True):
+                with self.subTest(callee=name, compact=compact):
+                    if compact:
+                        entries, packed = compact_chunk([main_entry], main_code)
+                        packed += [LVM_PAD] * (align_up(len(packed)) - len(packed))
+                        entries.append(FunctionEntry(0, len(packed), len(packed_callee), 1, 0, flags=FFLAG_REGISTER))
+                        state = VmState(consts, entries, packed + packed_callee, compact=True)
+                    else:
+                        callee_entry = FunctionEntry(0, len(main_code), len(mvp), 1, 0, flags=FFLAG_REGISTER)
+                        state = make_chunk(consts, main_code + mvp, [main_entry, callee_entry])
+                    self.assertEqual(predecode(state, lazy=True), "")
+                    state.tier = JitTier(lambda source, symbol: compiled.append(symbol), threshold=1)
+                    self.assertFalse(tier_up(state, 0))
+                    self.assertIsNone(state.tier.native[0])
+                    # Still runs interpreted; the callee is never decoded by the interpreter.
+                    self.assertEqual(vm_run(state), VmValue(VmValueTag.I64, 7))
+                    self.assertEqual(state.func_entry[1], -1)
+        self.assertEqual(compiled, [])
+
+        # Call to a function index that does not exist: rejected before any lookup.
+        bad_call = encode_inst(Opcode.OP_R_CALL, 1, 4, 0) + encode_inst(Opcode.OP_R_RET, 1)
+        state = make_chunk(consts, bad_call, [FunctionEntry(0, 0, len(bad_call), 0, 2, flags=FFLAG_REGISTER)])
+        self.assertEqual(jit_collect(state, 0), [])
+
+    def test_nanbox_round_trip(self) -> None:
+        heap: List[HeapObject] = []
+        values = [
+            VmValue(VmValueTag.NIL, None),
+            VmValue(VmValueTag.BOOL, True),
+            VmValue(VmValueTag.BOOL, False),
+            VmValue(VmValueTag.I64, 0),
+            VmValue(VmValueTag.I64, -1),
+            VmValue(VmValueTag.I64, NB_INT48_MIN),
+            VmValue(VmValueTag.I64, NB_INT48_MAX),
+            VmValue(VmValueTag.F64, -2.5),
+            VmValue(VmValueTag.F64, float("-inf")),
+            VmValue(VmValueTag.STRING, 3),
+            VmValue(VmValueTag.ARRAY, 7),
+            VmValue(VmValueTag.STRUCT, (1 << 48) - 1),
+        ]
+        for value in values:
+            self.assertEqual(vm_unbox(heap, vm_box(heap, value)), value)
+        self.assertEqual(heap, [])
+
+        big = VmValue(VmValueTag.I64, NB_INT48_MAX + 1)
+        bits = vm_box(heap, big)
+        self.assertEqual(bits >> 48, NB_TAG_BIG_INT)
+        self.assertEqual(vm_unbox(heap, bits), big)
+        self.assertEqual(vm_unbox(heap, vm_box(heap, VmValue(VmValueTag.I64, -(1 << 63)))).value, -(1 << 63))
+
+        # A negative-quiet NaN would alias the boxed tags; it is canonicalised first.
+        nan_bits = vm_box(heap, VmValue(VmValueTag.F64, struct.unpack("<d", struct.pack("<Q", 0xFFFB000000000001))[0]))
+        self.assertEqual(nan_bits, NB_CANONICAL_NAN)
+        self.assertEqual(vm_unbox(heap, nan_bits).tag, VmValueTag.F64)
+
+    def test_recomputed_big_ints_reuse_their_heap_object(self) -> None:
+        heap: List[HeapObject] = []
+        cache = [-1] * VM_BIG_CACHE_SLOTS
+        fnv_basis = VmValue(VmValueTag.I64, 0xCBF29CE484222325 - (1 << 64))
+        mask = VmValue(VmValueTag.I64, -(1 << 63))
+        first = vm_box(heap, fnv_basis, cache)
+        # Constantes rechargées à chaque tour : une seule allocation par valeur.
+        for _ in range(100):
+            self.assertEqual(vm_box(heap, fnv_basis, cache), first)
+            vm_box(heap, mask, cache)
+        self.assertEqual(len(heap), 2)
+
+        # Entrée périmée (objet collecté, index réutilisé) : revérifiée, pas crue.
+        heap[first & NB_PAYLOAD_MASK] = HeapObject(HeapTag.STRING, [])
+        bits = vm_box(heap, fnv_basis, cache)
+        self.assertNotEqual(bits, first)
+        self.assertEqual(vm_unbox(heap, bits), fnv_basis)
+        self.assertEqual(len(heap), 3)
+
+    def test_generational_gc_minor_promotes_and_barrier_keeps_nursery_alive(self) -> None:
+        heap: List[HeapObject] = []
+        gen = GcGenerations()
+        arr = VmValue(VmValueTag.ARRAY, heap_alloc(heap, HeapTag.ARRAY))
+        gc_collect(heap, gen, [arr], major=False)
+        self.assertEqual(gen.nursery_start, 1)
+
+        # Short-lived concat temporaries, one of which is stored into the old array.
+        for text in (b"tmp0", b"tmp1", b"kept", b"tmp2"):
+            ref = heap_alloc(heap, HeapTag.STRING)
+            heap[ref].payload = list(text)
+            if text == b"kept":
+                kept = VmValue(VmValueTag.STRING, ref)
+                gc_write_barrier(gen, arr.value, kept)
+                heap[arr.value].payload.append(kept)
+        self.assertEqual(gen.remembered, [arr.value])
+
+        gc_collect(heap, gen, [arr], major=False)
+        self.assertEqual(len(heap), 2)
+        self.assertEqual(gen.nursery_start, 2)
+        self.assertEqual(bytes(heap[heap[arr.value].payload[0].value].payload), b"kept")
+
+    def test_generational_gc_major_compacts_old_gen(self) -> None:
+        heap: List[HeapObject] = []
+        gen = GcGenerations()
+        dead = VmValue(VmValueTag.STRUCT, heap_alloc(heap, HeapTag.STRUCT))
+        inner = VmValue(VmValueTag.STRING, heap_alloc(heap, HeapTag.STRING))
+        outer = VmValue(VmValueTag.STRUCT, heap_alloc(heap, HeapTag.STRUCT))
+        heap[outer.value].payload.append(inner)
+        gc_collect(heap, gen, [dead, outer], major=False)
+        self.assertEqual(gen.nursery_start, 3)
+
+        # Old-gen garbage is only reclaimed by a major, which slides survivors down.
+        gc_collect(heap, gen, [outer], major=True)
+        self.assertEqual(len(heap), 2)
+        self.assertEqual(outer.value, 1)
+        self.assertEqual(heap[outer.value].payload[0].value, 0)
+        self.assertIs(heap[0].tag, HeapTag.STRING)
+
 
 if __name__ == "__main__":
     unittest.main()
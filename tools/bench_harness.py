@@ -0,0 +1,225 @@
+from __future__ import annotations
+
+from dataclasses import dataclass, field
+from typing import Callable, Dict, List, Optional
+import json
+import time
+
+
+# =============================================================================
+# Harnais de micro-benchmarks pour les hôtes Python (vittec bench).
+# Miroir de src/vitte/compiler/cli/bench.vitte :
+#   - warmup, calibrage (échantillon >= sample_ns, croissance bornée à ×10),
+#     puis `samples` échantillons à itérations fixes, en ps / itération ;
+#   - médiane et MAD entières, débit en octets/s ou opérations/s ;
+#   - JSON à un résultat par ligne, relu tel quel comme baseline ;
+#   - régression : plus lent de plus de threshold_pct % ET de plus de
+#     NOISE_MADS MAD.
+# =============================================================================
+
+WARMUP_NS = 100_000_000
+SAMPLE_NS = 10_000_000
+SAMPLES = 15
+MAX_ITERS = 1 << 30
+THRESHOLD_PCT = 5
+NOISE_MADS = 3
+
+UNITS = ("iters", "bytes", "ops")
+
+
+@dataclass
+class BenchCase:
+    name: str
+    unit: str
+    per_iter: int
+    run: Callable[[int], int]
+
+
+@dataclass
+class BenchConfig:
+    filter: str = ""
+    warmup_ns: int = WARMUP_NS
+    sample_ns: int = SAMPLE_NS
+    samples: int = SAMPLES
+    max_iters: int = MAX_ITERS
+    threshold_pct: int = THRESHOLD_PCT
+
+
+@dataclass
+class BenchStats:
+    name: str
+    unit: str
+    per_iter: int
+    iters: int
+    samples: int
+    median_ps: int
+    mad_ps: int
+    min_ps: int
+    per_sec: int
+    checksum: int = 0
+
+
+@dataclass
+class BenchVerdict:
+    name: str
+    base_ps: int = 0
+    delta_pct: int = 0
+    regressed: bool = False
+
+
+def _trunc_div(a: int, b: int) -> int:
+    # Division entière tronquée vers zéro, comme les i64 de Vitte.
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def median_sorted(values: List[int]) -> int:
+    n = len(values)
+    if n == 0:
+        return 0
+    if n % 2 == 1:
+        return values[n // 2]
+    return _trunc_div(values[n // 2 - 1] + values[n // 2], 2)
+
+
+def median_abs_dev(sorted_values: List[int], median: int) -> int:
+    return median_sorted(sorted(abs(v - median) for v in sorted_values))
+
+
+def per_second(per_iter: int, ps: int) -> int:
+    if ps <= 0:
+        return 0
+    return int(per_iter * 1e12 / ps)
+
+
+@dataclass
+class Harness:
+    # Horloge injectable : les tests passent un compteur déterministe.
+    clock: Callable[[], int] = time.perf_counter_ns
+    config: BenchConfig = field(default_factory=BenchConfig)
+
+    def time(self, case: BenchCase, iters: int) -> tuple[int, int]:
+        start = self.clock()
+        checksum = case.run(iters)
+        return self.clock() - start, checksum
+
+    def warmup(self, case: BenchCase) -> None:
+        start = self.clock()
+        iters = 1
+        while self.clock() - start < self.config.warmup_ns:
+            self.time(case, iters)
+            if iters * 2 <= self.config.max_iters:
+                iters *= 2
+
+    def calibrate(self, case: BenchCase) -> int:
+        cfg = self.config
+        iters = 1
+        while True:
+            ns, _ = self.time(case, iters)
+            if ns >= cfg.sample_ns or iters >= cfg.max_iters:
+                return iters
+            nxt = iters * 10
+            if ns > 0:
+                nxt = min(nxt, iters * cfg.sample_ns // ns + 1)
+            if nxt <= iters:
+                nxt = iters * 2
+            iters = min(nxt, cfg.max_iters)
+
+    def measure(self, case: BenchCase) -> BenchStats:
+        self.warmup(case)
+        iters = self.calibrate(case)
+        per_iter_ps: List[int] = []
+        checksum = 0
+        for _ in range(self.config.samples):
+            ns, sample_checksum = self.time(case, iters)
+            per_iter_ps.append(ns * 1000 // iters)
+            checksum += sample_checksum
+        per_iter_ps.sort()
+        median = median_sorted(per_iter_ps)
+        return BenchStats(
+            name=case.name,
+            unit=case.unit,
+            per_iter=case.per_iter,
+            iters=iters,
+            samples=self.config.samples,
+            median_ps=median,
+            mad_ps=median_abs_dev(per_iter_ps, median),
+            min_ps=per_iter_ps[0] if per_iter_ps else 0,
+            per_sec=0 if case.unit == "iters" else per_second(case.per_iter, median),
+            checksum=checksum,
+        )
+
+    def run_suite(self, cases: List[BenchCase]) -> List[BenchStats]:
+        return [self.measure(c) for c in cases if self.config.filter in c.name]
+
+
+def bench_json(results: List[BenchStats]) -> str:
+    keys = ("name", "unit", "per_iter", "iters", "samples", "median_ps", "mad_ps", "min_ps", "per_sec")
+    lines = [
+        "{" + ",".join(f"{json.dumps(k)}:{json.dumps(getattr(r, k))}" for k in keys) + "}"
+        for r in results
+    ]
+    return "{\"version\":1,\"results\":[\n" + ",\n".join(lines) + ("\n" if lines else "") + "]}\n"
+
+
+def parse_baseline(content: str) -> Dict[str, tuple[int, int]]:
+    # Le fichier est du JSON valide ; on le relit comme tel plutôt que ligne à
+    # ligne (bench.vitte n'a pas de parseur JSON, d'où son format ligne).
+    try:
+        doc = json.loads(content)
+    except json.JSONDecodeError:
+        return {}
+    out: Dict[str, tuple[int, int]] = {}
+    for r in doc.get("results", []):
+        if r.get("median_ps", -1) >= 0:
+            out[r["name"]] = (r["median_ps"], r.get("mad_ps", 0))
+    return out
+
+
+def compare(results: List[BenchStats], baseline: Dict[str, tuple[int, int]], threshold_pct: int) -> List[BenchVerdict]:
+    verdicts: List[BenchVerdict] = []
+    for r in results:
+        v = BenchVerdict(r.name)
+        base = baseline.get(r.name)
+        if base is not None and base[0] > 0:
+            slower = r.median_ps - base[0]
+            v.base_ps = base[0]
+            v.delta_pct = _trunc_div(slower * 100, base[0])
+            v.regressed = slower * 100 > base[0] * threshold_pct and slower > NOISE_MADS * r.mad_ps
+        verdicts.append(v)
+    return verdicts
+
+
+def any_regressed(verdicts: List[BenchVerdict]) -> bool:
+    return any(v.regressed for v in verdicts)
+
+
+def ns_text(ps: int) -> str:
+    return f"{ps // 1000}.{ps % 1000:03d}"
+
+
+def rate_text(per_sec: int, unit: str) -> str:
+    if unit == "iters":
+        return "-"
+    suffix = "B/s" if unit == "bytes" else "op/s"
+    if per_sec >= 1_000_000_000:
+        return f"{per_sec // 1_000_000} M{suffix}"
+    if per_sec >= 1_000_000:
+        return f"{per_sec // 1000} k{suffix}"
+    return f"{per_sec} {suffix}"
+
+
+def report(results: List[BenchStats], verdicts: Optional[List[BenchVerdict]] = None) -> str:
+    verdicts = verdicts or []
+    out = ["=== vittec bench ===",
+           f"{'case':<24}  {'iters':>10}  {'ns/iter':>12}  {'± MAD':>10}  {'throughput':>14}  baseline"]
+    for i, r in enumerate(results):
+        cmp = "-"
+        if i < len(verdicts) and verdicts[i].base_ps > 0:
+            v = verdicts[i]
+            cmp = ("+" if v.delta_pct >= 0 else "") + f"{v.delta_pct}%"
+            if v.regressed:
+                cmp += " REGRESSION"
+        out.append(f"{r.name:<24}  {r.iters:>10}  {ns_text(r.median_ps):>12}  {ns_text(r.mad_ps):>10}  "
+                   f"{rate_text(r.per_sec, r.unit):>14}  {cmp}")
+    return "\n".join(out) + "\n"
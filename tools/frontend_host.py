@@ -6,6 +6,11 @@ from pathlib import Path
 from typing import Dict, Iterable, List, Optional, Sequence, Tuple
 import re
 
+try:
+    from tools.pass_timer import DISABLED as _NO_TIMER, PassTimer
+except ImportError:  # exécuté depuis tools/ (run_parser_with_diags)
+    from pass_timer import DISABLED as _NO_TIMER, PassTimer  # type: ignore
+
 
 # =============================================================================
 # Frontend léger (Python) utilisé par le host bootstrap.
@@ -1074,19 +1079,211 @@ class Parser:
             self.advance()
 
 
-def run_frontend(path: Path) -> Tuple[int, List[Diagnostic]]:
-    text = path.read_text(encoding="utf-8")
-    lexer = Lexer(text, path)
-    tokens, lex_diags = lexer.lex()
-    parser = Parser(tokens)
-    parse_diags = parser.parse_file()
-    semantic_diags = run_semantic_checks(path, text)
-    diags = list(lex_diags) + list(parse_diags) + semantic_diags
-    for diag in diags:
-        diag.code = ERROR_CODE_BY_MESSAGE.get(diag.message, diag.code)
+def run_frontend(path: Path, db: Optional["FrontendDatabase"] = None) -> Tuple[int, List[Diagnostic]]:
+    # Passe par la base de requêtes : un fichier inchangé depuis l'appel
+    # précédent n'est ni relexé ni revérifié.
+    db = db if db is not None else DEFAULT_DATABASE
+    db.set_source(path, path.read_text(encoding="utf-8"))
+    diags = db.diagnostics(path)
     return (1 if diags else 0), diags
 
 
+def _with_codes(diags: Iterable[Diagnostic], line_offset: int = 0) -> List[Diagnostic]:
+    # Copies : les valeurs mémoïsées ne doivent pas être modifiées par
+    # l'appelant (run_parser_with_diags réécrit `code`).
+    out: List[Diagnostic] = []
+    for diag in diags:
+        span = Span(diag.span.file, diag.span.line + line_offset, diag.span.column)
+        code = ERROR_CODE_BY_MESSAGE.get(diag.message, diag.code)
+        out.append(Diagnostic(diag.message, span, code=code, severity=diag.severity))
+    return out
+
+
+# -----------------------------------------------------------------------------
+# Moteur de requêtes (LSP / check)
+#
+# Requêtes mémoïsées à la demande, avec suivi des dépendances :
+#   - une entrée (`set_input`) porte la révision à laquelle elle a changé ;
+#   - une requête enregistre les entrées et requêtes lues pendant son calcul ;
+#   - à la révision suivante, une requête n'est recalculée que si l'une de
+#     ses dépendances a changé depuis sa dernière vérification ;
+#   - coupure précoce : un résultat recalculé égal à l'ancien garde sa
+#     révision de changement, ses dépendants restent valides.
+#
+# Les requêtes par fonction travaillent en lignes relatives à l'en-tête :
+# insérer une ligne au-dessus d'une fonction ne la revérifie pas.
+# -----------------------------------------------------------------------------
+
+
+QueryKey = Tuple[object, ...]
+
+
+@dataclass
+class _Memo:
+    value: object
+    deps: List[QueryKey]
+    verified_at: int
+    changed_at: int
+
+
+class QueryDatabase:
+    def __init__(self) -> None:
+        self.revision = 0
+        self._inputs: Dict[QueryKey, Tuple[object, int]] = {}
+        self._memos: Dict[QueryKey, _Memo] = {}
+        self._queries: Dict[str, object] = {}
+        self._active: List[List[QueryKey]] = []
+        # Journal des calculs effectifs (statistiques, tests).
+        self.executed: List[QueryKey] = []
+        # --time-passes / --profile-json : seuls les calculs effectifs sont
+        # mesurés, une requête servie par la mémoire ne coûte rien.
+        self.timer: PassTimer = _NO_TIMER
+
+    def set_input(self, key: QueryKey, value: object) -> None:
+        current = self._inputs.get(key)
+        if current is not None and current[0] == value:
+            return
+        self.revision += 1
+        self._inputs[key] = (value, self.revision)
+
+    def input(self, key: QueryKey) -> object:
+        if self._active:
+            self._active[-1].append(key)
+        return self._inputs[key][0]
+
+    def register(self, name: str, compute) -> None:
+        self._queries[name] = compute
+
+    def query(self, name: str, *args: object) -> object:
+        key: QueryKey = (name,) + args
+        if self._active:
+            self._active[-1].append(key)
+        return self._memos[self._fetch(key)].value
+
+    def _changed_at(self, key: QueryKey) -> int:
+        if key in self._inputs:
+            return self._inputs[key][1]
+        self._fetch(key)
+        return self._memos[key].changed_at
+
+    def _fetch(self, key: QueryKey) -> QueryKey:
+        memo = self._memos.get(key)
+        if memo is not None and memo.verified_at == self.revision:
+            return key
+        if memo is not None and all(self._changed_at(d) <= memo.verified_at for d in memo.deps):
+            memo.verified_at = self.revision
+            return key
+        self._active.append([])
+        try:
+            value = self._queries[key[0]](self, *key[1:])
+        finally:
+            deps = self._active.pop()
+        self.executed.append(key)
+        if memo is not None and memo.value == value:
+            changed_at = memo.changed_at
+        else:
+            changed_at = self.revision
+        self._memos[key] = _Memo(value, deps, self.revision, changed_at)
+        return key
+
+
+@dataclass(frozen=True)
+class FnItem:
+    # Fonction indépendante de sa position : corps en lignes relatives.
+    name: str
+    params: Tuple[Tuple[str, Optional[str]], ...]
+    return_type: Optional[str]
+    body: Tuple[Tuple[int, str], ...]
+
+
+def _q_parse(db: QueryDatabase, path: Path) -> Tuple[Diagnostic, ...]:
+    text = db.input(("source", path))
+    with db.timer.phase("lex", str(path)):
+        tokens, lex_diags = Lexer(text, path).lex()
+    with db.timer.phase("parse", str(path)):
+        parse_diags = Parser(tokens).parse_file()
+    return tuple(lex_diags) + tuple(parse_diags)
+
+
+def _q_items(db: QueryDatabase, path: Path) -> Tuple[Tuple[str, int, FnItem], ...]:
+    # (id, ligne d'en-tête, fonction). L'id est `nom#k` pour la k-ième
+    # fonction de ce nom : stable tant que l'ordre des homonymes l'est.
+    text = db.input(("source", path))
+    seen: Dict[str, int] = {}
+    out = []
+    for fn in collect_functions(text.splitlines()):
+        k = seen.get(fn.name, 0)
+        seen[fn.name] = k + 1
+        body = tuple((line - fn.header_line, raw) for line, raw in fn.body)
+        item = FnItem(fn.name, tuple(fn.params), fn.return_type, body)
+        out.append((f"{fn.name}#{k}", fn.header_line, item))
+    return tuple(out)
+
+
+def _q_struct_names(db: QueryDatabase, path: Path) -> frozenset:
+    text = db.input(("source", path))
+    return frozenset(collect_struct_names(text.splitlines()))
+
+
+def _q_fn_item(db: QueryDatabase, path: Path, fn_id: str) -> Optional[FnItem]:
+    for item_id, _line, item in db.query("items", path):
+        if item_id == fn_id:
+            return item
+    return None
+
+
+def _q_item_signature(db: QueryDatabase, path: Path, fn_id: str) -> Optional[Tuple[object, ...]]:
+    item = db.query("fn_item", path, fn_id)
+    if item is None:
+        return None
+    return (item.name, item.params, item.return_type)
+
+
+def _q_typecheck_fn(db: QueryDatabase, path: Path, fn_id: str) -> Tuple[Diagnostic, ...]:
+    # Lignes relatives à l'en-tête de la fonction.
+    item = db.query("fn_item", path, fn_id)
+    if item is None:
+        return ()
+    fn = FunctionInfo(item.name, list(item.params), item.return_type, 0, list(item.body))
+    structs = db.query("struct_names", path)
+    with db.timer.phase("typecheck", f"{path}::{item.name}"):
+        return tuple(analyze_function(fn, structs, path))
+
+
+class FrontendDatabase(QueryDatabase):
+    def __init__(self) -> None:
+        super().__init__()
+        self.register("parse", _q_parse)
+        self.register("items", _q_items)
+        self.register("struct_names", _q_struct_names)
+        self.register("fn_item", _q_fn_item)
+        self.register("item_signature", _q_item_signature)
+        self.register("typecheck_fn", _q_typecheck_fn)
+
+    def set_source(self, path: Path, text: str) -> None:
+        self.set_input(("source", path), text)
+
+    def parse(self, path: Path) -> Tuple[Diagnostic, ...]:
+        return self.query("parse", path)
+
+    def item_signature(self, path: Path, fn_id: str) -> Optional[Tuple[object, ...]]:
+        return self.query("item_signature", path, fn_id)
+
+    def typecheck_fn(self, path: Path, fn_id: str) -> Tuple[Diagnostic, ...]:
+        return self.query("typecheck_fn", path, fn_id)
+
+    def diagnostics(self, path: Path) -> List[Diagnostic]:
+        # Même ordre que le pipeline complet : lex, parse, puis fonctions.
+        diags = _with_codes(self.parse(path))
+        for fn_id, header_line, _item in self.query("items", path):
+            diags.extend(_with_codes(self.typecheck_fn(path, fn_id), header_line))
+        return diags
+
+
+# Base partagée par run_frontend (host bootstrap, driver Python).
+DEFAULT_DATABASE = FrontendDatabase()
+
+
 # -----------------------------------------------------------------------------
 # Semantic checks (very lightweight scope/type simulation)
 # -----------------------------------------------------------------------------
@@ -0,0 +1,122 @@
+from __future__ import annotations
+
+from contextlib import contextmanager
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, Iterator, List, Optional
+import json
+import sys
+import time
+import tracemalloc
+
+
+# =============================================================================
+# Mesure des phases pour les hôtes Python (--time-passes / --profile-json).
+# Miroir de compiler/timing.vitte :
+#   - un évènement par (phase, module) : temps mur, allocations pendant la
+#     phase (blocs alloués par l'interpréteur) et pic du tas en fin de phase
+#     (tracemalloc, actif seulement quand la mesure l'est) ;
+#   - rapport texte par phase et trace Chrome (trace-event "X").
+# =============================================================================
+
+
+@dataclass
+class PassEvent:
+    name: str
+    module: str
+    start_ns: int
+    dur_ns: int
+    allocs: int
+    peak_bytes: int
+    worker: int = 0
+
+
+@dataclass
+class PassTimer:
+    enabled: bool = False
+    origin_ns: int = 0
+    events: List[PassEvent] = field(default_factory=list)
+
+    def __post_init__(self) -> None:
+        if self.enabled:
+            self.origin_ns = time.perf_counter_ns()
+            if not tracemalloc.is_tracing():
+                tracemalloc.start()
+
+    @contextmanager
+    def phase(self, name: str, module: str = "") -> Iterator[None]:
+        if not self.enabled:
+            yield
+            return
+        start = time.perf_counter_ns()
+        blocks = sys.getallocatedblocks()
+        try:
+            yield
+        finally:
+            self.events.append(
+                PassEvent(
+                    name=name,
+                    module=module,
+                    start_ns=start,
+                    dur_ns=time.perf_counter_ns() - start,
+                    allocs=max(sys.getallocatedblocks() - blocks, 0),
+                    peak_bytes=tracemalloc.get_traced_memory()[1],
+                )
+            )
+
+    def report(self, verbose: bool = False) -> str:
+        totals: Dict[str, List[int]] = {}
+        wall = 0
+        for ev in self.events:
+            t = totals.setdefault(ev.name, [0, 0, 0, 0])
+            t[0] += 1
+            t[1] += ev.dur_ns
+            t[2] += ev.allocs
+            t[3] = max(t[3], ev.peak_bytes)
+            wall = max(wall, ev.start_ns + ev.dur_ns - self.origin_ns)
+        lines = [
+            f"=== vittec --time-passes (wall {_ms(wall)} ms) ===",
+            f"{'phase':<20}  {'ms':>9}  {'count':>5}  {'allocs':>10}  peak",
+        ]
+        for name, (count, dur, allocs, peak) in totals.items():
+            lines.append(f"{name:<20}  {_ms(dur):>9}  {count:>5}  {allocs:>10}  {peak // 1024} KiB")
+        if verbose:
+            for ev in self.events:
+                if ev.module:
+                    lines.append(f"  {ev.name:<18}  {_ms(ev.dur_ns):>9}  {ev.module}")
+        return "\n".join(lines) + "\n"
+
+    def chrome_trace(self) -> str:
+        events = [
+            {
+                "name": ev.name,
+                "cat": "vittec",
+                "ph": "X",
+                "pid": 1,
+                "tid": ev.worker,
+                "ts": (ev.start_ns - self.origin_ns) // 1000,
+                "dur": ev.dur_ns // 1000,
+                "args": {"module": ev.module, "allocs": ev.allocs, "peak_bytes": ev.peak_bytes},
+            }
+            for ev in self.events
+        ]
+        return json.dumps({"displayTimeUnit": "ms", "traceEvents": events}, indent=0) + "\n"
+
+    def finish(self, time_passes: bool, profile_json: Optional[Path]) -> None:
+        if not self.enabled:
+            return
+        if time_passes:
+            print(self.report(), end="")
+        if profile_json is not None:
+            profile_json.parent.mkdir(parents=True, exist_ok=True)
+            profile_json.write_text(self.chrome_trace(), encoding="utf-8")
+
+
+def _ms(ns: int) -> str:
+    us = ns // 1000
+    return f"{us // 1000}.{us % 1000:03d}"
+
+
+# Timer inactif partagé : `phase` ne coûte rien tant qu'aucun hôte n'active
+# la mesure.
+DISABLED = PassTimer(enabled=False)